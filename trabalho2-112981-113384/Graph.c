@@ -3,32 +3,59 @@
 //
 // Joaquim Madeira, Joao Manuel Rodrigues - June 2021, Nov 2023
 //
-// Graph - Using a list of adjacency lists representation
+// Graph - Using an array of vertices, whose edges are sorted blocks of a
+// per-graph edge arena (with an optional hash index of the edges, and
+// optional blocks of incoming edges)
 //
 
 #include "Graph.h"
 
 #include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-#include "SortedList.h"
-#include "instrumentation.h"
+#include "GraphFileParser.h"
 
-/* Dados de um vértice */
+/* 
+  Dados de um vértice
+  As suas arestas estão guardadas num bloco da arena de arestas do grafo (ver abaixo), em duas zonas paralelas
+  ordenadas pelo ID do vértice adjacente, o que permite entregá-las sem cópias (ver GraphGetAdjacents) e
+  procurá-las por pesquisa binária
+*/
 struct _Vertex {
   unsigned int id;          /* ID do vértice */
   unsigned int inDegree;    /* Número de arestas incidentes */
-  unsigned int outDegree;   /* Número de arestas que saem dele */
-  List* edgesList;          /* Lista de arestas */
+  unsigned int outDegree;   /* Número de arestas que saem dele (== número de adjacentes guardados no bloco) */
+  unsigned int capacity;    /* Número de arestas que cabem no seu bloco (0 se ainda não tiver bloco) */
+  size_t first;             /* Posição do início do seu bloco na arena */
 };
 
-/* Dados de uma aresta */
-struct _Edge {
-  unsigned int adjVertex;   /* Vértice adjacente */
-  double weight;            /* Custo */
+/* Número de classes de tamanho dos blocos da arena: a classe k agrupa os blocos com lugar para 2^k a 2^(k+1) - 1 arestas */
+#define NUM_SIZE_CLASSES 32
+
+/* Marca o fim de uma lista de blocos livres */
+#define NO_BLOCK ((size_t)-1)
+
+/*
+  Índice (opcional) das arestas: tabela de dispersão com endereçamento aberto e sondagem linear, cujas chaves são
+  os pares (v, w) -> (v << 32) | w. Num grafo não orientado, cada aresta tem as duas chaves, (v, w) e (w, v)
+  As remoções deslocam para trás as chaves seguintes do mesmo grupo, pelo que não há marcas de posições apagadas
+*/
+struct _EdgeIndex {
+  uint64_t* keys;     /* Chaves (EMPTY_KEY nas posições livres) */
+  double* weights;    /* Custos das arestas correspondentes (NULL se o grafo não for weighted) */
+  size_t capacity;    /* Número de posições (potência de 2) */
+  size_t size;        /* Número de chaves guardadas */
+  unsigned int shift; /* 64 - log2(capacity): a dispersão usa os bits mais significativos do produto */
 };
 
+/* Nenhum vértice tem ID UINT_MAX, pelo que esta chave nunca corresponde a uma aresta */
+#define EMPTY_KEY UINT64_MAX
+
 /* Cabeçalho de um grafo -> Dados que o compẽm */
 struct _GraphHeader {
   int isDigraph;            /* É grafo orientado? 0 ou 1 */
@@ -36,30 +63,317 @@ struct _GraphHeader {
   int isWeighted;           /* Tem custos nas suas arestas? 0 ou 1 */
   unsigned int numVertices; /* Número de vértices */
   unsigned int numEdges;    /* Número de arestas */
-  List* verticesList;       /* Lista dos vértices */
+  struct _Vertex* vertices; /* Array dos vértices, indexado pelo seu ID */
+
+  /*
+    Arena das arestas: todos os blocos dos vértices vivem nestes dois arrays (o segundo só existe se o grafo for weighted),
+    que crescem geometricamente. Os blocos libertados ficam numa lista por classe de tamanho, para serem reutilizados,
+    e os blocos novos são retirados do fim da zona usada. Assim, um grafo ocupa um punhado de alocações, seja qual for
+    o seu número de vértices, e não há um malloc/realloc/free por vértice
+  */
+  unsigned int* adjacentsPool;          /* Vértices adjacentes */
+  double* weightsPool;                  /* Custos das arestas correspondentes (NULL se o grafo não for weighted) */
+  size_t poolSize;                      /* Número de posições já entregues a blocos (usados ou livres) */
+  size_t poolCapacity;                  /* Número de posições alocadas */
+  size_t freeBlocks[NUM_SIZE_CLASSES];  /* Primeiro bloco livre de cada classe (NO_BLOCK se não houver) */
+
+  struct _EdgeIndex* edgeIndex;         /* Índice das arestas (NULL se não tiver sido pedido) */
+
+  /*
+    Arestas incidentes (opcional, só em digrafos): incoming[w] descreve um bloco da mesma arena com os vértices de
+    origem das arestas que chegam a 'w', ordenados, e os respetivos custos; aí, outDegree conta essas arestas
+  */
+  struct _Vertex* incoming;             /* NULL se não tiver sido pedido */
 };
 
-/* Definir as macros a serem usadas para a análise da complexidade */
-#define VERTEX_ITER InstrCount[0]
-#define EDGE_ITER InstrCount[1]
-#define EDGE_REM InstrCount[2]
+// AUXILIARY FUNCTIONS for the EDGES ARENA
+
+/* Adjacentes do vértice 'v' (endereço válido apenas até à próxima alteração da arena) */
+static inline unsigned int* _adjacents(const Graph* g, const struct _Vertex* v) {
+  return g->adjacentsPool + v->first;
+}
+
+/* Custos das arestas do vértice 'v' (NULL se o grafo não for weighted) */
+static inline double* _weights(const Graph* g, const struct _Vertex* v) {
+  return g->isWeighted ? g->weightsPool + v->first : NULL;
+}
+
+/* Classe de tamanho de um bloco com lugar para 'capacity' arestas (== floor(log2(capacity))) */
+static unsigned int _sizeClass(size_t capacity) {
+  unsigned int k = 0;
+  while (capacity > 1) {
+    capacity >>= 1;
+    k++;
+  }
+  return k;
+}
+
+/*
+  Um bloco livre guarda, nas suas duas primeiras posições, a posição do bloco livre seguinte da mesma classe
+  (por isso, nenhum bloco tem lugar para menos de 2 arestas)
+*/
+static size_t _nextFreeBlock(const Graph* g, size_t block) {
+  uint64_t next;
+  memcpy(&next, &g->adjacentsPool[block], sizeof(next));
+  return (size_t)next;
+}
+
+static void _setNextFreeBlock(Graph* g, size_t block, size_t next) {
+  uint64_t value = (uint64_t)next;
+  memcpy(&g->adjacentsPool[block], &value, sizeof(value));
+}
+
+/* Garantir que a arena tem lugar para mais 'extra' posições, além das já entregues */
+static void _growPool(Graph* g, size_t extra) {
+  if (g->poolSize + extra <= g->poolCapacity) return;
+
+  size_t newCapacity = (g->poolCapacity < 64) ? 64 : 2 * g->poolCapacity;
+  if (newCapacity < g->poolSize + extra) newCapacity = g->poolSize + extra;
+
+  g->adjacentsPool = (unsigned int*)realloc(g->adjacentsPool, newCapacity * sizeof(unsigned int));
+  if (g->adjacentsPool == NULL) abort();
+
+  if (g->isWeighted) {
+    g->weightsPool = (double*)realloc(g->weightsPool, newCapacity * sizeof(double));
+    if (g->weightsPool == NULL) abort();
+  }
+
+  g->poolCapacity = newCapacity;
+}
+
+/* Retirar um bloco com lugar para exatamente 'capacity' arestas do fim da zona usada da arena */
+static size_t _takeBlock(Graph* g, size_t capacity) {
+  _growPool(g, capacity);
+  size_t block = g->poolSize;
+  g->poolSize += capacity;
+  return block;
+}
+
+/*
+  Atribuir a 'v' um bloco com lugar para, pelo menos, 'capacity' arestas, vindo da lista de blocos livres da sua classe
+  ou, se esta estiver vazia, do fim da arena. Devolve a capacidade do bloco
+  Se 'exact' for 0, a capacidade é arredondada à potência de 2 seguinte (crescimento geométrico das inserções);
+  caso contrário, o bloco fica com o tamanho pedido (construção de uma só vez, em que o tamanho final já é conhecido)
+*/
+static unsigned int _allocBlock(Graph* g, struct _Vertex* v, unsigned int capacity, int exact) {
+  if (capacity < 2) capacity = 2;
+
+  if (!exact) {
+    unsigned int k = _sizeClass(capacity);
+    if (((size_t)1 << k) < capacity) k++;
+    capacity = (unsigned int)((size_t)1 << k);
+
+    /* Qualquer bloco livre da classe k tem lugar para, pelo menos, 2^k arestas */
+    size_t block = g->freeBlocks[k];
+    if (block != NO_BLOCK) {
+      g->freeBlocks[k] = _nextFreeBlock(g, block);
+      v->first = block;
+      v->capacity = capacity;
+      return capacity;
+    }
+  }
+
+  v->first = _takeBlock(g, capacity);
+  v->capacity = capacity;
+  return capacity;
+}
+
+/* Devolver o bloco de 'v' à lista de blocos livres da sua classe */
+static void _freeBlock(Graph* g, struct _Vertex* v) {
+  if (v->capacity == 0) return;
+
+  unsigned int k = _sizeClass(v->capacity);
+  _setNextFreeBlock(g, v->first, g->freeBlocks[k]);
+  g->freeBlocks[k] = v->first;
+
+  v->capacity = 0;
+  v->first = 0;
+}
+
+/* Garantir que o bloco de 'v' tem lugar para, pelo menos, 'capacity' arestas */
+static void _reserve(Graph* g, struct _Vertex* v, unsigned int capacity) {
+  if (capacity <= v->capacity) return;
+
+  /* A capacidade cresce geometricamente, para que as inserções sucessivas tenham custo amortizado constante */
+  unsigned int newCapacity = (v->capacity < 4) ? 4 : 2 * v->capacity;
+  if (newCapacity < capacity) newCapacity = capacity;
+
+  /* Mudar as arestas para um bloco maior, libertando o antigo */
+  struct _Vertex old = *v;
+  _allocBlock(g, v, newCapacity, 0);
+
+  if (old.outDegree > 0) {
+    memcpy(_adjacents(g, v), _adjacents(g, &old), old.outDegree * sizeof(unsigned int));
+    if (g->isWeighted) {
+      memcpy(_weights(g, v), _weights(g, &old), old.outDegree * sizeof(double));
+    }
+  }
+
+  _freeBlock(g, &old);
+}
+
+/* Pesquisa binária de 'w' nos adjacentes de 'v': devolve a posição onde está ou onde deveria ser inserido */
+static unsigned int _findAdjacent(const Graph* g, const struct _Vertex* v, unsigned int w) {
+  const unsigned int* adjacents = _adjacents(g, v);
+  unsigned int low = 0;
+  unsigned int high = v->outDegree;
+  while (low < high) {
+    unsigned int mid = low + (high - low) / 2;
+    if (adjacents[mid] < w) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/* Inserir a aresta (v, w), mantendo a ordem: devolve 1 se foi inserida e 0 se já existia */
+static int _insertAdjacent(Graph* g, struct _Vertex* v, unsigned int w, double weight) {
+  unsigned int pos = _findAdjacent(g, v, w);
+  if (pos < v->outDegree && _adjacents(g, v)[pos] == w) {
+    return 0;  /* Já existe !! */
+  }
+
+  _reserve(g, v, v->outDegree + 1);
+
+  /* Abrir espaço na posição 'pos', deslocando os elementos seguintes */
+  unsigned int* adjacents = _adjacents(g, v);
+  unsigned int tail = v->outDegree - pos;
+  memmove(&adjacents[pos + 1], &adjacents[pos], tail * sizeof(unsigned int));
+  adjacents[pos] = w;
+  if (g->isWeighted) {
+    double* weights = _weights(g, v);
+    memmove(&weights[pos + 1], &weights[pos], tail * sizeof(double));
+    weights[pos] = weight;
+  }
+
+  v->outDegree++;
+  return 1;
+}
+
+/* Remover a aresta (v, w): devolve 1 se foi removida e 0 se não existia */
+static int _removeAdjacent(Graph* g, struct _Vertex* v, unsigned int w) {
+  unsigned int pos = _findAdjacent(g, v, w);
+  unsigned int* adjacents = _adjacents(g, v);
+  if (pos == v->outDegree || adjacents[pos] != w) {
+    return 0;
+  }
+
+  /* Fechar o espaço deixado na posição 'pos' */
+  unsigned int tail = v->outDegree - pos - 1;
+  memmove(&adjacents[pos], &adjacents[pos + 1], tail * sizeof(unsigned int));
+  if (g->isWeighted) {
+    double* weights = _weights(g, v);
+    memmove(&weights[pos], &weights[pos + 1], tail * sizeof(double));
+  }
+
+  /* Sem arestas, o bloco volta à arena, para ser reutilizado por outro vértice */
+  if (--v->outDegree == 0) {
+    _freeBlock(g, v);
+  }
+  return 1;
+}
+
+
+// AUXILIARY FUNCTIONS for the EDGE INDEX
+
+static inline uint64_t _edgeKey(unsigned int v, unsigned int w) { return ((uint64_t)v << 32) | w; }
+
+/* Posição inicial da chave 'key' (dispersão multiplicativa de Fibonacci) */
+static inline size_t _home(const struct _EdgeIndex* index, uint64_t key) {
+  return (size_t)((key * UINT64_C(0x9E3779B97F4A7C15)) >> index->shift);
+}
+
+static struct _EdgeIndex* _indexCreate(size_t capacity, int isWeighted) {
+  struct _EdgeIndex* index = (struct _EdgeIndex*)malloc(sizeof(struct _EdgeIndex));
+  if (index == NULL) abort();
+
+  index->capacity = capacity;
+  index->size = 0;
+  index->shift = 64 - _sizeClass(capacity);
+
+  index->keys = (uint64_t*)malloc(capacity * sizeof(uint64_t));
+  index->weights = isWeighted ? (double*)malloc(capacity * sizeof(double)) : NULL;
+  if (index->keys == NULL || (isWeighted && index->weights == NULL)) abort();
+
+  for (size_t k = 0; k < capacity; k++) {
+    index->keys[k] = EMPTY_KEY;
+  }
+  return index;
+}
+
+static void _indexDestroy(struct _EdgeIndex* index) {
+  if (index == NULL) return;
+  free(index->keys);
+  free(index->weights);
+  free(index);
+}
+
+/* Posição da chave 'key' no índice, ou da posição livre onde deveria estar */
+static size_t _indexSlot(const struct _EdgeIndex* index, uint64_t key) {
+  size_t mask = index->capacity - 1;
+  size_t slot = _home(index, key);
+  while (index->keys[slot] != EMPTY_KEY && index->keys[slot] != key) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+static void _indexInsert(struct _EdgeIndex* index, unsigned int v, unsigned int w, double weight);
+
+/* Duplicar a capacidade do índice, voltando a inserir todas as chaves */
+static void _indexGrow(struct _EdgeIndex* index) {
+  struct _EdgeIndex old = *index;
+  struct _EdgeIndex* bigger = _indexCreate(2 * old.capacity, old.weights != NULL);
+
+  for (size_t k = 0; k < old.capacity; k++) {
+    if (old.keys[k] != EMPTY_KEY) {
+      size_t slot = _indexSlot(bigger, old.keys[k]);
+      bigger->keys[slot] = old.keys[k];
+      if (old.weights != NULL) bigger->weights[slot] = old.weights[k];
+      bigger->size++;
+    }
+  }
+
+  *index = *bigger;
+  free(bigger);
+  free(old.keys);
+  free(old.weights);
+}
+
+/* Acrescentar o arco (v, w), que ainda não está no índice (a ocupação nunca passa de metade) */
+static void _indexInsert(struct _EdgeIndex* index, unsigned int v, unsigned int w, double weight) {
+  if (2 * (index->size + 1) > index->capacity) {
+    _indexGrow(index);
+  }
 
-// The comparator for the VERTICES LIST
-/* Comparador de vértices com base nos seus IDs (retorna 1 se ID de v1 > ID de v2, -1 caso seja menor e 0 se forem iguais) */
-int graphVerticesComparator(const void* p1, const void* p2) {
-  unsigned int v1 = ((struct _Vertex*)p1)->id;
-  unsigned int v2 = ((struct _Vertex*)p2)->id;
-  int d = v1 - v2;
-  return (d > 0) - (d < 0);
+  uint64_t key = _edgeKey(v, w);
+  size_t slot = _indexSlot(index, key);
+  assert(index->keys[slot] == EMPTY_KEY);
+  index->keys[slot] = key;
+  if (index->weights != NULL) index->weights[slot] = weight;
+  index->size++;
 }
 
-// The comparator for the EDGES LISTS
-/* Comparador de arestas com base nos IDs dos respetivos vértices adjacentes (retorna 1 se ID de v1 > ID de v2, -1 caso seja menor e 0 se forem iguais) */
-int graphEdgesComparator(const void* p1, const void* p2) {
-  unsigned int v1 = ((struct _Edge*)p1)->adjVertex;
-  unsigned int v2 = ((struct _Edge*)p2)->adjVertex;
-  int d = v1 - v2;
-  return (d > 0) - (d < 0);
+/* Retirar o arco (v, w) do índice, deslocando para trás as chaves seguintes que deixariam de ser encontradas */
+static void _indexRemove(struct _EdgeIndex* index, unsigned int v, unsigned int w) {
+  size_t mask = index->capacity - 1;
+  size_t hole = _indexSlot(index, _edgeKey(v, w));
+  if (index->keys[hole] == EMPTY_KEY) return;
+
+  for (size_t slot = (hole + 1) & mask; index->keys[slot] != EMPTY_KEY; slot = (slot + 1) & mask) {
+    /* A chave em 'slot' pode passar para 'hole' se a sua posição inicial não estiver entre os dois (circularmente) */
+    size_t home = _home(index, index->keys[slot]);
+    if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+      index->keys[hole] = index->keys[slot];
+      if (index->weights != NULL) index->weights[hole] = index->weights[slot];
+      hole = slot;
+    }
+  }
+
+  index->keys[hole] = EMPTY_KEY;
+  index->size--;
 }
 
 
@@ -76,25 +390,39 @@ Graph* GraphCreate(unsigned int numVertices, int isDigraph, int isWeighted) {
   g->numVertices = numVertices;
   g->numEdges = 0;
 
-  /* Criar uma lista com os seus vértices, de acordo com os seus IDs */
-  g->verticesList = ListCreate(graphVerticesComparator);
+  /* 
+    Criar um array com os seus vértices: como os IDs são 0..numVertices-1, o vértice 'i' está na posição 'i'
+    e o acesso a qualquer vértice é O(1), sem percorrer nenhuma lista ("+ 1" para nunca pedir 0 bytes)
+  */
+  g->vertices = (struct _Vertex*)malloc((numVertices + 1) * sizeof(struct _Vertex));
+  if (g->vertices == NULL) abort();
+
+  /* A arena das arestas começa vazia: só é alocada quando for acrescentada a primeira aresta */
+  g->adjacentsPool = NULL;
+  g->weightsPool = NULL;
+  g->poolSize = 0;
+  g->poolCapacity = 0;
+  for (unsigned int k = 0; k < NUM_SIZE_CLASSES; k++) {
+    g->freeBlocks[k] = NO_BLOCK;
+  }
+
+  /* O índice das arestas e as arestas incidentes só são construídos quando forem pedidos */
+  g->edgeIndex = NULL;
+  g->incoming = NULL;
 
   /* E, para cada vértice... */
   for (unsigned int i = 0; i < numVertices; i++) {
-    struct _Vertex* v = (struct _Vertex*)malloc(sizeof(struct _Vertex));
-    if (v == NULL) abort();
+    struct _Vertex* v = &g->vertices[i];
 
     v->id = i;        /* ... atribuir-lhe um ID, ... */
     v->inDegree = 0;  /* ... inicializar o seu número de arestas incidentes, ... */
-    v->outDegree = 0; /* ... inicializar o número de arestas que saem dele, ... */
+    v->outDegree = 0; /* ... inicializar o número de arestas que saem dele ... */
 
-    v->edgesList = ListCreate(graphEdgesComparator);  /* ... criar uma lista ordenada, que conterá os vértices adjacente a ele ... */
-
-    ListInsert(g->verticesList, v);                   /* ... e adicionar o vértice à lista de vértices do grafo */
+    /* ... e deixar o bloco das arestas por atribuir, até lá ser inserida a primeira */
+    v->capacity = 0;
+    v->first = 0;
   }
 
-  assert(g->numVertices == ListGetSize(g->verticesList));
-
   return g;
 }
 
@@ -107,54 +435,41 @@ Graph* GraphCreateComplete(unsigned int numVertices, int isDigraph) {
 
   g->isComplete = 1;                /* Classifica-se como sendo um grafo completo */
 
-  List* vertices = g->verticesList; /* Obtém-se a lista dos seus vértices */
-  ListMoveToHead(vertices);         /* Aponta-se para o primeiro vértice na lista */
-  unsigned int i = 0;
-  
-  /* E, para cada vértice... */
-  for (; i < g->numVertices; ListMoveToNext(vertices), i++) {
+  if (numVertices < 2) {
+    return g;
+  }
 
-    /* ... obtém-se o mesmo, ...*/
-    struct _Vertex* v = ListGetCurrentItem(vertices);
+  /* Número de arestas do grafo completo, caso seja tanto um digrafo como um grafo não orientado */
+  size_t numEdges = (size_t)numVertices * (numVertices - 1);
+  if (!isDigraph) {
+    numEdges /= 2;
+  }
 
-    /* ... obtém-se a lista das suas arestas/vértices adjacentes, ... */
-    List* edges = v->edgesList;
+  unsigned int* src = (unsigned int*)malloc(numEdges * sizeof(unsigned int));
+  unsigned int* dst = (unsigned int*)malloc(numEdges * sizeof(unsigned int));
+  if (src == NULL || dst == NULL) abort();
 
-    /*... percorrem-se de novo todos os vértices da lista do grafo, ... */
-    for (unsigned int j = 0; j < g->numVertices; j++) {
-      /* ... caso seja igual ao vértice da iteração atual, então salta esta iteração (não existem lacetes), ... */ 
+  /* Para cada par de vértices distintos (num grafo não orientado, basta i < j), ... */
+  size_t k = 0;
+  for (unsigned int i = 0; i < numVertices; i++) {
+    for (unsigned int j = isDigraph ? 0 : i + 1; j < numVertices; j++) {
+      /* ... caso seja igual ao vértice da iteração atual, então salta esta iteração (não existem lacetes), ... */
       if (i == j) {
         continue;
       }
 
-      /* ... aloca-se memória para uma nova aresta que ligará o vértice da iteração do primeiro ciclo ao da iteração do segundo ciclo, ... */
-      struct _Edge* new = (struct _Edge*)malloc(sizeof(struct _Edge));
-      if (new == NULL) abort();
-
-      /* ... define-se como vértice adjacente (ligado à aresta criada em cima) o da iteração atual do segundo ciclo, ... */
-      new->adjVertex = j;
-      new->weight = 1;    // não é weighted
-
-      /* ... adiciona-se o novo vértice adjacente (é adjacente através da aresta new) à lista das arestas do vértice da iteração do primeiro ciclo, ...*/
-      ListInsert(edges, new);
-    }
-
-    /* ... se for digrafo, ... */
-    if (g->isDigraph) {
-      v->inDegree = g->numVertices - 1;   /* ... o seu grau de entrada é agora o maior possível num digrafo completo, ... */
-      v->outDegree = g->numVertices - 1;  /* ... o seu grau de saída é agora o maior possível num digrafo completo, ... */
-    } else {
-      /* ... e, finalmente, caso não seja digrafo, ... */
-      v->outDegree = g->numVertices - 1;  /* ... então o seu grau é agora o maior possível num grafo completo, ... */
+      /* ... regista-se a aresta (i, j) */
+      src[k] = i;
+      dst[k] = j;
+      k++;
     }
   }
 
-  /* Voltando ao tratamento do grafo completo, ... */ 
-  if (g->isDigraph) {
-    g->numEdges = numVertices * (numVertices - 1);      /* ... o seu número de arestas é máximo, caso seja tanto um digrafo ... */
-  } else {
-    g->numEdges = numVertices * (numVertices - 1) / 2;  /* ... como um grafo não orientado */
-  }
+  /* E acrescentam-se todas de uma só vez: os graus ficam máximos e o número de arestas também */
+  GraphAddEdgesBatch(g, src, dst, NULL, numEdges);
+
+  free(src);
+  free(dst);
 
   /* Devolver o grafo criado */
   return g;
@@ -166,35 +481,19 @@ void GraphDestroy(Graph** p) {
   assert(*p != NULL);
   Graph* g = *p;
 
-  List* vertices = g->verticesList;
-  if (ListIsEmpty(vertices) == 0) {
-    ListMoveToHead(vertices);
-    unsigned int i = 0;
-    for (; i < g->numVertices; ListMoveToNext(vertices), i++) {
-      struct _Vertex* v = ListGetCurrentItem(vertices);
-
-      List* edges = v->edgesList;
-      if (ListIsEmpty(edges) == 0) {
-        unsigned int i = 0;
-        ListMoveToHead(edges);
-        for (; i < ListGetSize(edges); ListMoveToNext(edges), i++) {
-          struct _Edge* e = ListGetCurrentItem(edges);
-          free(e);
-        }
-      }
-      ListDestroy(&(v->edgesList));
-      free(v);
-    }
-  }
-
-  ListDestroy(&(g->verticesList));
+  /* Os blocos das arestas de todos os vértices estão na arena: basta libertá-la */
+  free(g->adjacentsPool);
+  free(g->weightsPool);
+  _indexDestroy(g->edgeIndex);
+  free(g->incoming);
+  free(g->vertices);
   free(g);
 
   *p = NULL;
 }
 
 
-/* Copiar um grafo (função a ser usada numa das implementações de ordenação topológica) */
+/* Copiar um grafo */
 Graph* GraphCopy(const Graph* g) {
   assert(g != NULL);
 
@@ -202,150 +501,245 @@ Graph* GraphCopy(const Graph* g) {
   Graph* copy = GraphCreate(g->numVertices, g->isDigraph, g->isWeighted);
   assert(copy != NULL);
 
-  /* Lista dos vértices do grafo original */
-  List* originalVertices = g->verticesList;
-
-  /* Lista dos vértices do grafo cópia */
-  List* copyVertices = copy->verticesList;
-
-  /* Apontar para o início das duas listas */
-  ListMoveToHead(originalVertices);
-  ListMoveToHead(copyVertices);
-
-  /* Para cada vértice do grafo original, copiá-lo para o grafo cópia */
-  for (unsigned int i = 0; i < g->numVertices; ListMoveToNext(originalVertices), ListMoveToNext(copyVertices), i++) {
-
-    /* Incrementar o número de iterações */
-    VERTEX_ITER++;
+  /* Alocar, de uma só vez, a arena da cópia: tem o tamanho da zona usada da arena do original */
+  _growPool(copy, g->poolSize);
 
-    /* Vértice do grafo g, original */
-    struct _Vertex* vOriginal = ListGetCurrentItem(originalVertices);
-
-    /* Vértice do grafo cópia */
-    struct _Vertex* vCopy = ListGetCurrentItem(copyVertices);
-
-    /* Ao vértice do grafo cópia, atribuir as características do vérice do grafo original */
-    vCopy->id = vOriginal->id;                // esta linha pode ser omitida
-    vCopy->inDegree = vOriginal->inDegree;
-    vCopy->outDegree = vOriginal->outDegree;
-
-    /* Lista das arestas relativas ao vértice do grafo original (com os respetivos vértices adjacentes) */
-    List* vOriginalEdges = vOriginal->edgesList;
-
-    /* Colocar o ponteiro no início da lista referida acima */
-    ListMoveToHead(vOriginalEdges);
-
-    /* Para cada aresta do grafo original */
-    for (unsigned int j = 0; j < ListGetSize(vOriginalEdges); ListMoveToNext(vOriginalEdges), j++) {
-
-      /* Incrementar o contador EDGE_ITER */
-      EDGE_ITER++;
+  /* Os vértices guardam apenas posições na arena, pelo que a cópia é feita com três memcpy, sem percorrer os vértices */
+  if (g->numVertices > 0) {
+    memcpy(copy->vertices, g->vertices, g->numVertices * sizeof(struct _Vertex));
+  }
+  if (g->poolSize > 0) {
+    memcpy(copy->adjacentsPool, g->adjacentsPool, g->poolSize * sizeof(unsigned int));
+    if (g->isWeighted) {
+      memcpy(copy->weightsPool, g->weightsPool, g->poolSize * sizeof(double));
+    }
+  }
 
-      /* Obter a aresta do grafo g (original) desta iteração */
-      struct _Edge* edgeOriginal = ListGetCurrentItem(vOriginalEdges);
+  /* Os blocos das arestas incidentes estão na mesma arena, pelo que basta copiar as suas posições */
+  if (g->incoming != NULL) {
+    copy->incoming = (struct _Vertex*)malloc((g->numVertices + 1) * sizeof(struct _Vertex));
+    if (copy->incoming == NULL) abort();
+    memcpy(copy->incoming, g->incoming, g->numVertices * sizeof(struct _Vertex));
+  }
 
-      /* Alocar memória para a aresta do grafo cópia desta iteração */
-      struct _Edge* edgeCopy = (struct _Edge*) malloc(sizeof(struct _Edge));
-      if (edgeCopy == NULL) abort();
+  /* As listas de blocos livres também são válidas na cópia */
+  copy->poolSize = g->poolSize;
+  memcpy(copy->freeBlocks, g->freeBlocks, sizeof(copy->freeBlocks));
 
-      /* Copiar os dados da aresta original para a aresta cópia */
-      edgeCopy->adjVertex = edgeOriginal->adjVertex;
-      edgeCopy->weight = edgeOriginal->weight;
+  /* Copiar o número de arestas do grafo original para o grafo cópia */
+  copy->numEdges = g->numEdges;
 
-      /* E adicionar a aresta na lista de arestas do vértice do grafo cópia */
-      ListInsert(vCopy->edgesList, edgeCopy);
+  /* Se o original tiver índice das arestas, a cópia também fica com um (as posições das chaves não mudam) */
+  if (g->edgeIndex != NULL) {
+    const struct _EdgeIndex* index = g->edgeIndex;
+    copy->edgeIndex = _indexCreate(index->capacity, g->isWeighted);
+    memcpy(copy->edgeIndex->keys, index->keys, index->capacity * sizeof(uint64_t));
+    if (g->isWeighted) {
+      memcpy(copy->edgeIndex->weights, index->weights, index->capacity * sizeof(double));
     }
+    copy->edgeIndex->size = index->size;
   }
 
-  /* Copiar o número de arestas do grafo original para o grafo cópia */
-  copy->numEdges = g->numEdges;
-
   /* Devolver a cópia do grafo */
   return copy;
 }
 
 
-/* Ler a informação de um grafo a partir de um ficheiro de texto */
-Graph* GraphFromFile(FILE* f) {
-  assert(f != NULL);
-
-  /* Ler a primeira linha, que informa se é ou não grafo orientado */
-  int isDigraph;
-  if (fscanf(f, "%d", &isDigraph) != 1) {
-    fprintf(stderr, "Error reading if is digraph\n");
-    return NULL;
+/*
+  Acrescentar, de uma só vez, as arestas (src[i], dst[i]), com custo weights[i] (NULL se o grafo não for weighted):
+    1 - ordenação por contagem (estável) dos arcos pelo vértice de destino;
+    2 - contagem dos arcos de cada vértice de origem, somas prefixas e espalhamento (estável) por origem;
+    3 - para cada vértice de origem, descartar as repetições e as arestas que já existem (percorrendo, em paralelo,
+        os seus adjacentes, já ordenados) e juntar as restantes aos adjacentes, de trás para a frente, no próprio bloco.
+  Num grafo não orientado, a aresta i dá origem a dois arcos: 2i (src -> dst) e 2i+1 (dst -> src).
+  O resultado é o mesmo que o de acrescentar as arestas, uma a uma e por ordem, com GraphAddEdge
+  (ou GraphAddWeightedEdge), mas em tempo O(V + E + n), sem nenhuma inserção ordenada
+*/
+unsigned int GraphAddEdgesBatch(Graph* g, const unsigned int* src, const unsigned int* dst,
+                                const double* weights, size_t numEdges) {
+  assert(g != NULL);
+  assert((weights != NULL) == (g->isWeighted != 0));
+  assert(numEdges <= (g->isDigraph ? UINT_MAX : UINT_MAX / 2));
+
+  if (numEdges == 0) return 0;
+
+  unsigned int n = g->numVertices;
+  unsigned int numArcs = (unsigned int)(g->isDigraph ? numEdges : 2 * numEdges);
+
+  /* Vértices de origem e de destino de cada arco */
+  const unsigned int* arcSrc = src;
+  const unsigned int* arcDst = dst;
+  unsigned int* arcs = NULL;
+  if (!g->isDigraph) {
+    arcs = (unsigned int*)malloc(2 * (size_t)numArcs * sizeof(unsigned int));
+    if (arcs == NULL) abort();
+    for (size_t i = 0; i < numEdges; i++) {
+      arcs[2 * i] = src[i];
+      arcs[2 * i + 1] = dst[i];
+      arcs[numArcs + 2 * i] = dst[i];
+      arcs[numArcs + 2 * i + 1] = src[i];
+    }
+    arcSrc = arcs;
+    arcDst = arcs + numArcs;
   }
 
-  /* Ler a segunda linha, que informa se o grafo tem ou não custos associados às arestas */
-  int isWeighted;
-  if (fscanf(f, "%d", &isWeighted) != 1) {
-    fprintf(stderr, "Error reading if is weighted graph\n");
-    return NULL;
+  unsigned int* next = (unsigned int*)calloc(n + 1, sizeof(unsigned int));
+  unsigned int* offsets = (unsigned int*)calloc(n + 1, sizeof(unsigned int));
+  unsigned int* byDst = (unsigned int*)malloc((size_t)numArcs * sizeof(unsigned int));
+  unsigned int* bySrc = (unsigned int*)malloc((size_t)numArcs * sizeof(unsigned int));
+  if (next == NULL || offsets == NULL || byDst == NULL || bySrc == NULL) abort();
+
+  /* 1 - Ordenar os arcos pelo vértice de destino */
+  for (unsigned int a = 0; a < numArcs; a++) {
+    assert(arcSrc[a] < n && arcDst[a] < n);
+    assert(arcSrc[a] != arcDst[a]);
+    next[arcDst[a] + 1]++;
+  }
+  for (unsigned int v = 0; v < n; v++) {
+    next[v + 1] += next[v];
+  }
+  for (unsigned int a = 0; a < numArcs; a++) {
+    byDst[next[arcDst[a]]++] = a;
   }
 
-  /* Ler a terceira linha, que informa sobre o número de vértices do grafo */
-  unsigned int numVertices;
-  if (fscanf(f, "%u", &numVertices) != 1) {
-    fprintf(stderr, "Error reading number of vertices\n");
-    return NULL;
+  /* 2 - Ordenar (de forma estável) pelo vértice de origem: ficam ordenados por origem, destino e posição no lote */
+  for (unsigned int a = 0; a < numArcs; a++) {
+    offsets[arcSrc[a] + 1]++;
+  }
+  for (unsigned int v = 0; v < n; v++) {
+    offsets[v + 1] += offsets[v];
+    next[v] = offsets[v];
+  }
+  for (unsigned int k = 0; k < numArcs; k++) {
+    unsigned int a = byDst[k];
+    bySrc[next[arcSrc[a]]++] = a;
   }
 
-  /* Ler a quarta linha, que informa sobre o número de arestas do grafo */
-  unsigned int numEdges;
-  if (fscanf(f, "%u", &numEdges) != 1) {
-    fprintf(stderr, "Error reading number of edges\n");
-    return NULL;
+  /* Num grafo ainda sem arestas, a arena é reservada de uma só vez (contando já com as repetições) */
+  if (g->numEdges == 0) {
+    _growPool(g, numArcs);
   }
 
-  /* Criar um novo grafo */
-  Graph* g = GraphCreate(numVertices, isDigraph, isWeighted);
-  if (g == NULL) return NULL;
+  /* 3 - Juntar os arcos novos de cada vértice aos seus adjacentes */
+  unsigned int added = 0;
+  for (unsigned int v = 0; v < n; v++) {
+    struct _Vertex* vertex = &g->vertices[v];
+
+    unsigned int begin = offsets[v];
+    unsigned int end = offsets[v + 1];
+    if (begin == end) continue;
+
+    /*
+      Ficar apenas com os arcos novos, guardados de novo em bySrc[begin..]: de cada grupo de arcos repetidos fica
+      o primeiro do lote (que tem o menor índice de arco), e só se a aresta ainda não existir
+    */
+    const unsigned int* adjacents = (vertex->outDegree > 0) ? _adjacents(g, vertex) : NULL;
+    unsigned int pos = 0;
+    unsigned int numNew = 0;
+    unsigned int previous = 0;
+    for (unsigned int k = begin; k < end; k++) {
+      unsigned int a = bySrc[k];
+      unsigned int w = arcDst[a];
+
+      if (k > begin && w == previous) continue;
+      previous = w;
+
+      while (pos < vertex->outDegree && adjacents[pos] < w) pos++;
+      if (pos < vertex->outDegree && adjacents[pos] == w) continue;
+
+      bySrc[begin + numNew++] = a;
+
+      /* Tal como em _addEdge, cada aresta conta uma única vez, no sentido em que foi acrescentada */
+      if (g->isDigraph || a % 2 == 0) {
+        g->vertices[w].inDegree++;
+        added++;
+      }
+    }
+    if (numNew == 0) continue;
 
-  /* 
-    Criar um ciclo 'for' para ler o ficheiro até ao fim. O ficheiro apresenta os dados da seguinte forma:
-          -> primeira coluna: vértice inicial;
-          -> segunda coluna: vértice final;
-          -> terceira coluna: apenas existe se o grafo for weighted, e indica o custo da aresta entre os dois vértices acima referidos. 
-  */
-  for (unsigned int i = 0; i < numEdges; i++) {
+    /* Um vértice sem arestas recebe um bloco com o tamanho exato; os outros crescem geometricamente */
+    if (vertex->outDegree == 0 && vertex->capacity == 0) {
+      _allocBlock(g, vertex, numNew, 1);
+    } else {
+      _reserve(g, vertex, vertex->outDegree + numNew);
+    }
 
-    /* Vértice inicial e vértice final */
-    unsigned int v, w;
+    /* Junção, de trás para a frente, dos adjacentes com os arcos novos (nunca há valores iguais) */
+    unsigned int* vertexAdjacents = _adjacents(g, vertex);
+    double* vertexWeights = _weights(g, vertex);
+    unsigned int i = vertex->outDegree;
+    unsigned int j = numNew;
+    unsigned int out = vertex->outDegree + numNew;
+    while (j > 0) {
+      out--;
+      unsigned int a = bySrc[begin + j - 1];
+      if (i > 0 && vertexAdjacents[i - 1] > arcDst[a]) {
+        i--;
+        vertexAdjacents[out] = vertexAdjacents[i];
+        if (g->isWeighted) vertexWeights[out] = vertexWeights[i];
+      } else {
+        j--;
+        vertexAdjacents[out] = arcDst[a];
+        if (g->isWeighted) vertexWeights[out] = weights[g->isDigraph ? a : a / 2];
+      }
+    }
 
-    /* Variável que conterá o custo da aresta, se for weighted */
-    double weight;
+    /* Os graus de saída são atualizados uma única vez por vértice */
+    vertex->outDegree += numNew;
 
-    /* Ler os dois vértices */
-    if (fscanf(f, "%u %u", &v, &w) != 2) {
-      fprintf(stderr, "Error reading edge on line %d\n", 4+i+1);
-      GraphDestroy(&g);
-      return NULL;
+    if (g->edgeIndex != NULL) {
+      for (unsigned int k = begin; k < begin + numNew; k++) {
+        unsigned int a = bySrc[k];
+        _indexInsert(g->edgeIndex, v, arcDst[a], g->isWeighted ? weights[g->isDigraph ? a : a / 2] : 1.0);
+      }
     }
 
-    /* Se os vértices forem iguais, como não existem lacetes, passa-se para a próxima iteração */
-    if (v == w) {
-      continue;
+    /* As origens chegam por ordem crescente, pelo que cada uma é acrescentada no fim das arestas incidentes de 'w' */
+    if (g->incoming != NULL) {
+      for (unsigned int k = begin; k < begin + numNew; k++) {
+        unsigned int a = bySrc[k];
+        _insertAdjacent(g, &g->incoming[arcDst[a]], v, g->isWeighted ? weights[a] : 1.0);
+      }
     }
+  }
 
-    /* Ler o custo da aresta, se for weighted */
-    if (isWeighted) {
-      if (fscanf(f, "%lf", &weight) != 1) {
-        fprintf(stderr, "Error reading edge weight on line %d\n", 4+i+1);
-        GraphDestroy(&g);
-        return NULL;
-      }
+  g->numEdges += added;
 
-      /* Adicionar a aresta com custo ao grafo */
-      GraphAddWeightedEdge(g, v, w, weight);
+  free(arcs);
+  free(next);
+  free(offsets);
+  free(byDst);
+  free(bySrc);
 
-    } else {
+  return added;
+}
 
-      /* Adicionar a aresta sem custo ao grafo */
-      GraphAddEdge(g, v, w);
 
-    }
+/* Ler a informação de um grafo a partir de um ficheiro de texto */
+Graph* GraphFromFile(FILE* f) {
+  assert(f != NULL);
+
+  /* 
+    Ler o ficheiro todo para arrays com as suas arestas (já sem os lacetes). O ficheiro apresenta:
+          -> nas quatro primeiras linhas: se é orientado, se é weighted, o número de vértices e o número de arestas;
+          -> depois, uma aresta por linha: vértice inicial, vértice final e, apenas se o grafo for weighted, o seu custo.
+    O ficheiro é mapeado em memória e as linhas das arestas são lidas por várias threads (ver GraphFileParser.c)
+  */
+  GraphFileData* data = GraphFileParse(f);
+  if (data == NULL) return NULL;
+
+  /* Criar um novo grafo */
+  Graph* g = GraphCreate(data->numVertices, data->isDigraph, data->isWeighted);
+  if (g == NULL) {
+    GraphFileDataDestroy(&data);
+    return NULL;
   }
 
+  /* E acrescentar-lhe todas as arestas de uma só vez */
+  GraphAddEdgesBatch(g, data->src, data->dst, data->weights, data->numEdges);
+
+  GraphFileDataDestroy(&data);
+
   return g;
 }
 
@@ -375,14 +769,9 @@ double GraphGetAverageDegree(const Graph* g) {
 
 /* Obter o maior grau entre os vértices do grafo (tal e qual como descobrir o máximo de uma lista de inteiros) */
 static unsigned int _GetMaxDegree(const Graph* g) {
-  List* vertices = g->verticesList;
-  if (ListIsEmpty(vertices)) return 0;
-
   unsigned int maxDegree = 0;
-  ListMoveToHead(vertices);
-  unsigned int i = 0;
-  for (; i < g->numVertices; ListMoveToNext(vertices), i++) {
-    struct _Vertex* v = ListGetCurrentItem(vertices);
+  for (unsigned int i = 0; i < g->numVertices; i++) {
+    struct _Vertex* v = &g->vertices[i];
     if (v->outDegree > maxDegree) {
       maxDegree = v->outDegree;
     }
@@ -412,6 +801,20 @@ unsigned int GraphGetMaxOutDegree(const Graph* g) {
 
 // Vertices
 
+/* Obter, sem cópias, os adjacentes do vértice 'v' e os custos das respetivas arestas */
+GraphAdjacents GraphGetAdjacents(const Graph* g, unsigned int v) {
+  assert(v < g->numVertices);
+
+  const struct _Vertex* vPointer = &g->vertices[v];
+
+  GraphAdjacents adj;
+  adj.numAdjacents = vPointer->outDegree;
+  adj.vertices = (vPointer->capacity > 0) ? _adjacents(g, vPointer) : NULL;
+  adj.weights = (vPointer->capacity > 0) ? _weights(g, vPointer) : NULL;
+  return adj;
+}
+
+
 //
 // returns an array of size (outDegree + 1)
 // element 0, stores the number of adjacent vertices
@@ -421,18 +824,11 @@ unsigned int GraphGetMaxOutDegree(const Graph* g) {
 unsigned int* GraphGetAdjacentsTo(const Graph* g, unsigned int v) {
   assert(v < g->numVertices);
 
-  // Node in the list of vertices
-  /* Obter a lista de vértices do grafo */
-  List* vertices = g->verticesList;
-
-  /* Nessa lista, apontar para a posição onde está o vértice 'v', inserido como argumento */
-  ListMove(vertices, v);     
-
-  /* Estando já a apontar para a posição desejada, então obtém-se o item (ponteiro para void) que lá está ('v'), realizando um cast */       
-  struct _Vertex* vPointer = ListGetCurrentItem(vertices);  
+  /* Obter os adjacentes do vértice 'v', inserido como argumento */
+  GraphAdjacents adj = GraphGetAdjacents(g, v);
 
   /* O número de vértices adjacentes corresponde ao grau de saída do vértice 'v' */
-  unsigned int numAdjVertices = vPointer->outDegree;
+  unsigned int numAdjVertices = adj.numAdjacents;
 
   /* 
     Aloca espaço para uma lista de double que conterá os vértices adjacentes 
@@ -445,19 +841,8 @@ unsigned int* GraphGetAdjacentsTo(const Graph* g, unsigned int v) {
     /* O primeiro elemento corresponde, então, ao número de vértices adjacentes */ 
     adjacent[0] = numAdjVertices;
 
-    /* Obter a lista das arestas adjacentes (aquelas a que o vértice está ligado) */
-    List* adjList = vPointer->edgesList;
-
-    /* Apontar para o início dessa lista */
-    ListMoveToHead(adjList);
-
-    /* Agora, para cada aresta do array acima (adjacente ao vértice), ... */
-    for (unsigned int i = 0; i < numAdjVertices; ListMoveToNext(adjList), i++) {
-      /* ... obter o ponteiro para ela ... */
-      struct _Edge* ePointer = ListGetCurrentItem(adjList);
-      /* ... e adicionar o vértice que está na outra ponta ao array dos vértices adjacentes */
-      adjacent[i + 1] = ePointer->adjVertex;
-    }
+    /* E os seguintes são os vértices adjacentes, copiados do grafo */
+    memcpy(&adjacent[1], adj.vertices, numAdjVertices * sizeof(unsigned int));
   }
 
   return adjacent;
@@ -476,21 +861,16 @@ unsigned int* GraphGetAdjacentsTo(const Graph* g, unsigned int v) {
 double* GraphGetDistancesToAdjacents(const Graph* g, unsigned int v) {
   assert(v < g->numVertices);
 
-  // Node in the list of vertices
-  List* vertices = g->verticesList;
-  ListMove(vertices, v);
-  struct _Vertex* vPointer = ListGetCurrentItem(vertices);
-  unsigned int numAdjVertices = vPointer->outDegree;
+  GraphAdjacents adj = GraphGetAdjacents(g, v);
+  unsigned int numAdjVertices = adj.numAdjacents;
 
   double* distance = (double*)calloc(1 + numAdjVertices, sizeof(double));
 
   if (numAdjVertices > 0) {
     distance[0] = numAdjVertices;
-    List* adjList = vPointer->edgesList;
-    ListMoveToHead(adjList);
-    for (unsigned int i = 0; i < numAdjVertices; ListMoveToNext(adjList), i++) {
-      struct _Edge* ePointer = ListGetCurrentItem(adjList);
-      distance[i + 1] = ePointer->weight;
+    for (unsigned int i = 0; i < numAdjVertices; i++) {
+      /* Num grafo que não é weighted, todas as arestas têm custo 1 */
+      distance[i + 1] = (adj.weights != NULL) ? adj.weights[i] : 1.0;
     }
   }
 
@@ -502,14 +882,11 @@ double* GraphGetDistancesToAdjacents(const Graph* g, unsigned int v) {
 // For a graph
 //
 /* Obter o grau associado a um vértice 'v' num grafo */
-unsigned int GraphGetVertexDegree(Graph* g, unsigned int v) {
+unsigned int GraphGetVertexDegree(const Graph* g, unsigned int v) {
   assert(g->isDigraph == 0);
   assert(v < g->numVertices);
 
-  ListMove(g->verticesList, v);
-  struct _Vertex* p = ListGetCurrentItem(g->verticesList);
-
-  return p->outDegree;
+  return g->vertices[v].outDegree;
 }
 
 
@@ -517,14 +894,11 @@ unsigned int GraphGetVertexDegree(Graph* g, unsigned int v) {
 // For a digraph
 //
 /* Obter o grau de saída associado a um vértice 'v' num digrafo */
-unsigned int GraphGetVertexOutDegree(Graph* g, unsigned int v) {
+unsigned int GraphGetVertexOutDegree(const Graph* g, unsigned int v) {
   assert(g->isDigraph == 1);
   assert(v < g->numVertices);
 
-  ListMove(g->verticesList, v);
-  struct _Vertex* p = ListGetCurrentItem(g->verticesList);
-
-  return p->outDegree;
+  return g->vertices[v].outDegree;
 }
 
 
@@ -532,58 +906,50 @@ unsigned int GraphGetVertexOutDegree(Graph* g, unsigned int v) {
 // For a digraph
 //
 /* Obter o grau de entrada associado a um vértice 'v' num digrafo */
-unsigned int GraphGetVertexInDegree(Graph* g, unsigned int v) {
+unsigned int GraphGetVertexInDegree(const Graph* g, unsigned int v) {
   assert(g->isDigraph == 1);
   assert(v < g->numVertices);
 
-  ListMove(g->verticesList, v);
-  struct _Vertex* p = ListGetCurrentItem(g->verticesList);
-
-  return p->inDegree;
+  return g->vertices[v].inDegree;
 }
 
 
 // Edges
 /* Adicionar uma aresta com ou sem custo a um grafo */
 static int _addEdge(Graph* g, unsigned int v, unsigned int w, double weight) {
-  struct _Edge* edge = (struct _Edge*)malloc(sizeof(struct _Edge));
-  edge->adjVertex = w;
-  edge->weight = weight;
+  /* Com o índice, uma aresta repetida é recusada sem procurar nos adjacentes */
+  if (g->edgeIndex != NULL && GraphHasEdge(g, v, w)) {
+    return 0;
+  }
 
-  ListMove(g->verticesList, v);
-  struct _Vertex* vertex = ListGetCurrentItem(g->verticesList);
-  int result = ListInsert(vertex->edgesList, edge);
+  /* A inserção também atualiza o grau de saída de 'v' */
+  int result = _insertAdjacent(g, &g->vertices[v], w, weight);
 
-  if (result == -1) {
-    free(edge);
+  if (result == 0) {
     return 0;
   } else {
     g->numEdges++;
-    vertex->outDegree++;
+    g->vertices[w].inDegree++;
+  }
 
-    ListMove(g->verticesList, w);
-    struct _Vertex* destVertex = ListGetCurrentItem(g->verticesList);
-    destVertex->inDegree++;
+  if (g->edgeIndex != NULL) {
+    _indexInsert(g->edgeIndex, v, w, weight);
+    if (g->isDigraph == 0) _indexInsert(g->edgeIndex, w, v, weight);
+  }
+
+  if (g->incoming != NULL) {
+    _insertAdjacent(g, &g->incoming[w], v, weight);
   }
 
   if (g->isDigraph == 0) {
     // Bidirectional edge
-    struct _Edge* edge = (struct _Edge*)malloc(sizeof(struct _Edge));
-    edge->adjVertex = v;
-    edge->weight = weight;
-
-    ListMove(g->verticesList, w);
-    struct _Vertex* vertex = ListGetCurrentItem(g->verticesList);
-    result = ListInsert(vertex->edgesList, edge);
+    result = _insertAdjacent(g, &g->vertices[w], v, weight);
 
-    if (result == -1) {
-      free(edge);
+    if (result == 0) {
       return 0;
-    } else {
-      // g->numEdges++; // Do not count the same edge twice on a undirected
-      // graph !!
-      vertex->outDegree++;
     }
+    // g->numEdges++; // Do not count the same edge twice on a undirected
+    // graph !!
   }
 
   return 1;
@@ -616,78 +982,236 @@ int GraphAddWeightedEdge(Graph* g, unsigned int v, unsigned int w,
 /* Remover uma aresta de um grafo usando os dois vértices extremos desta */
 int GraphRemoveEdge(Graph* g, unsigned int v, unsigned int w) {
   assert(g != NULL);
+  assert(v < g->numVertices);
+  assert(w < g->numVertices);
 
-  /* Apontar para a poição do vértice 'v' na lista */
-  ListMove(g->verticesList, v);
-  /* Obter o seu ponteiro */
-  struct _Vertex* vertex = ListGetCurrentItem(g->verticesList);
+  /* Com o índice, sabe-se logo se a aresta existe */
+  if (g->edgeIndex != NULL) {
+    if (!GraphHasEdge(g, v, w)) return 0;
+    _indexRemove(g->edgeIndex, v, w);
+    if (!g->isDigraph) _indexRemove(g->edgeIndex, w, v);
+  }
 
-  /* Apontar para oo início da lista de arestas ligadas ao vértice 'v' */
-  ListMoveToHead(vertex->edgesList);
+  /* Procurar (por pesquisa binária) e remover a aresta do array de arestas do vértice 'v' */
+  if (_removeAdjacent(g, &g->vertices[v], w) == 0) {
+    /* A aresta não existe: nada a fazer */
+    return 0;
+  }
 
-  /* Para cada aresta na lista acima */
-  for (unsigned int i = 0; i < ListGetSize(vertex->edgesList); ListMoveToNext(vertex->edgesList), i++) {
+  /* Atualizar o número de arestas */
+  g->numEdges--;
 
-    /* Incrementar o contador EDGE_ITER */
-    EDGE_ITER++;
+  /* Fazer o mesmo para o vértice adjacente: atualizar o seu grau de entrada */
+  g->vertices[w].inDegree--;
 
-    /* Obter o seu ponteiro */
-    struct _Edge* e = ListGetCurrentItem(vertex->edgesList);
+  if (g->incoming != NULL) {
+    _removeAdjacent(g, &g->incoming[w], v);
+  }
 
-    /* Verificar se o outro vértice extremo (adjacente a 'v') corresponde ao vértice 'w' da aresta desejada */
-    if (e->adjVertex == w) {
+  /* Se for um grafo não direcionado, remover no sentido oposto, i.e., do vértice adjacente 'w' para 'v' */
+  if (!g->isDigraph /*== 0*/) {
+    _removeAdjacent(g, &g->vertices[w], v);
+  }
 
-      /* Remover a aresta que liga os dois (que corresponde à aresta desta iteração) */
-      ListRemoveCurrent(vertex->edgesList);
+  return 1;
+}
 
-      /* Libertar a memória associada à aresta */
-      free(e);
 
-      /* Sair do ciclo 'for' */
-      break;
+/* Construir o índice das arestas, com todas as que o grafo já tem */
+void GraphEnableEdgeIndex(Graph* g) {
+  assert(g != NULL);
+  if (g->edgeIndex != NULL) return;
+
+  /* Capacidade inicial: a potência de 2 que deixa a ocupação entre um quarto e metade */
+  size_t numArcs = g->isDigraph ? g->numEdges : 2 * (size_t)g->numEdges;
+  size_t capacity = 16;
+  while (capacity < 2 * numArcs) capacity *= 2;
+
+  g->edgeIndex = _indexCreate(capacity, g->isWeighted);
+
+  for (unsigned int v = 0; v < g->numVertices; v++) {
+    GraphAdjacents adj = GraphGetAdjacents(g, v);
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+      _indexInsert(g->edgeIndex, v, adj.vertices[j], (adj.weights != NULL) ? adj.weights[j] : 1.0);
     }
   }
+}
 
-  /* Atualizar o número de arestas */
-  g->numEdges--;
+/* Libertar o índice das arestas */
+void GraphDisableEdgeIndex(Graph* g) {
+  assert(g != NULL);
+  _indexDestroy(g->edgeIndex);
+  g->edgeIndex = NULL;
+}
 
-  /* Atualizar o grau do vértice */
-  vertex->outDegree--;
+int GraphHasEdgeIndex(const Graph* g) { return g->edgeIndex != NULL; }
 
-  /* Fazer o mesmo para o vértice adjacente: */
-  /* Apontar para a poição do vértice 'w' na lista */
-  ListMove(g->verticesList, w);
-  /* Obter o seu ponteiro */
-  struct _Vertex* adjVertex = ListGetCurrentItem(g->verticesList);
-  /* Atualizar o seu grau */
-  adjVertex->inDegree--;
+/* Saber se a aresta (v, w) existe: O(1) com o índice, pesquisa binária nos adjacentes de 'v' sem ele */
+int GraphHasEdge(const Graph* g, unsigned int v, unsigned int w) {
+  assert(v < g->numVertices);
+  assert(w < g->numVertices);
 
-  /* Se for um grafo não direcionado, remover no sentido oposto, i.e., do vértice adjacente 'w' para 'v' */
-  if (!g->isDigraph /*== 0*/) {
+  if (g->edgeIndex != NULL) {
+    const struct _EdgeIndex* index = g->edgeIndex;
+    return index->keys[_indexSlot(index, _edgeKey(v, w))] != EMPTY_KEY;
+  }
 
-    /* Obter o vértice */
-    ListMove(g->verticesList, w);
-    struct _Vertex* vertex = ListGetCurrentItem(g->verticesList);
+  const struct _Vertex* vertex = &g->vertices[v];
+  unsigned int pos = _findAdjacent(g, vertex, w);
+  return pos < vertex->outDegree && _adjacents(g, vertex)[pos] == w;
+}
 
-    /* Obter a aresta a remover */
-    ListMoveToHead(vertex->edgesList);
-    for (unsigned int i = 0; i < ListGetSize(vertex->edgesList); ListMoveToNext(vertex->edgesList), i++) {
-      struct _Edge* e = ListGetCurrentItem(vertex->edgesList);
-      if (e->adjVertex == v) {
+/* Obter o custo da aresta (v, w) */
+double GraphGetEdgeWeight(const Graph* g, unsigned int v, unsigned int w) {
+  assert(v < g->numVertices);
+  assert(w < g->numVertices);
 
-        /* Remover a aresta */
-        ListRemoveCurrent(vertex->edgesList);
+  if (g->edgeIndex != NULL) {
+    const struct _EdgeIndex* index = g->edgeIndex;
+    size_t slot = _indexSlot(index, _edgeKey(v, w));
+    if (index->keys[slot] == EMPTY_KEY) return INFINITY;
+    return g->isWeighted ? index->weights[slot] : 1.0;
+  }
 
-        /* Libertar a memória associada à aresta */
-        free(e);
-        break;
-      }
+  const struct _Vertex* vertex = &g->vertices[v];
+  unsigned int pos = _findAdjacent(g, vertex, w);
+  if (pos == vertex->outDegree || _adjacents(g, vertex)[pos] != w) return INFINITY;
+  return g->isWeighted ? _weights(g, vertex)[pos] : 1.0;
+}
+
+
+/* Construir, de uma só vez (O(V + E)), as arestas incidentes de todos os vértices de um digrafo */
+void GraphEnableIncomingEdges(Graph* g) {
+  assert(g != NULL);
+  if (!g->isDigraph || g->incoming != NULL) return;
+
+  unsigned int n = g->numVertices;
+  g->incoming = (struct _Vertex*)malloc((n + 1) * sizeof(struct _Vertex));
+  if (g->incoming == NULL) abort();
+
+  /* Cada vértice recebe um bloco com o tamanho exato (o seu grau de entrada), ainda vazio */
+  _growPool(g, g->numEdges);
+  for (unsigned int w = 0; w < n; w++) {
+    struct _Vertex* in = &g->incoming[w];
+    in->id = w;
+    in->inDegree = 0;
+    in->outDegree = 0;
+    in->capacity = 0;
+    in->first = 0;
+    if (g->vertices[w].inDegree > 0) {
+      _allocBlock(g, in, g->vertices[w].inDegree, 1);
+    }
+  }
+
+  /* Percorrendo as origens por ordem crescente, as arestas incidentes de cada vértice ficam logo ordenadas */
+  for (unsigned int v = 0; v < n; v++) {
+    GraphAdjacents adj = GraphGetAdjacents(g, v);
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+      struct _Vertex* in = &g->incoming[adj.vertices[j]];
+      _adjacents(g, in)[in->outDegree] = v;
+      if (g->isWeighted) _weights(g, in)[in->outDegree] = adj.weights[j];
+      in->outDegree++;
+    }
+  }
+}
+
+/* Devolver os blocos das arestas incidentes à arena */
+void GraphDisableIncomingEdges(Graph* g) {
+  assert(g != NULL);
+  if (g->incoming == NULL) return;
+
+  for (unsigned int w = 0; w < g->numVertices; w++) {
+    _freeBlock(g, &g->incoming[w]);
+  }
+  free(g->incoming);
+  g->incoming = NULL;
+}
+
+int GraphHasIncomingEdges(const Graph* g) { return !g->isDigraph || g->incoming != NULL; }
+
+/* Obter, sem cópias, as origens das arestas que chegam a 'w' (num grafo não orientado, são os seus adjacentes) */
+GraphAdjacents GraphGetIncoming(const Graph* g, unsigned int w) {
+  assert(w < g->numVertices);
+  assert(GraphHasIncomingEdges(g));
+
+  if (!g->isDigraph) return GraphGetAdjacents(g, w);
+
+  const struct _Vertex* in = &g->incoming[w];
+
+  GraphAdjacents adj;
+  adj.numAdjacents = in->outDegree;
+  adj.vertices = (in->capacity > 0) ? _adjacents(g, in) : NULL;
+  adj.weights = (in->capacity > 0) ? _weights(g, in) : NULL;
+  return adj;
+}
+
+//
+// returns an array of size (inDegree + 1)
+// element 0, stores the number of vertices
+// and is followed by the indices of those vertices
+//
+/* Obter as origens das arestas que chegam a 'w': sem as arestas incidentes guardadas, percorre todo o grafo */
+unsigned int* GraphGetIncomingTo(const Graph* g, unsigned int w) {
+  assert(w < g->numVertices);
+
+  if (GraphHasIncomingEdges(g)) {
+    GraphAdjacents adj = GraphGetIncoming(g, w);
+    unsigned int* incoming = (unsigned int*)calloc(1 + adj.numAdjacents, sizeof(unsigned int));
+    if (incoming == NULL) abort();
+    incoming[0] = adj.numAdjacents;
+    if (adj.numAdjacents > 0) {
+      memcpy(&incoming[1], adj.vertices, adj.numAdjacents * sizeof(unsigned int));
     }
-    /* Atualizar o grau do vértice adjacente */
-    vertex->outDegree--;
+    return incoming;
+  }
 
+  unsigned int* incoming = (unsigned int*)calloc(1 + g->vertices[w].inDegree, sizeof(unsigned int));
+  if (incoming == NULL) abort();
+  for (unsigned int v = 0; v < g->numVertices; v++) {
+    const struct _Vertex* vertex = &g->vertices[v];
+    unsigned int pos = _findAdjacent(g, vertex, w);
+    if (pos < vertex->outDegree && _adjacents(g, vertex)[pos] == w) {
+      incoming[1 + incoming[0]++] = v;
+    }
   }
-  return 0;
+  return incoming;
+}
+
+
+/* Criar o grafo transposto (com as arestas invertidas), em tempo O(V + E) */
+Graph* GraphTranspose(const Graph* g) {
+  assert(g != NULL);
+
+  /* Um grafo não orientado é o seu próprio transposto */
+  if (!g->isDigraph) return GraphCopy(g);
+
+  unsigned int n = g->numVertices;
+  Graph* t = GraphCreate(n, 1, g->isWeighted);
+  t->isComplete = g->isComplete;
+  t->numEdges = g->numEdges;
+
+  /* Os graus trocam: cada vértice de 't' recebe um bloco com o tamanho exato do seu grau de saída */
+  _growPool(t, g->numEdges);
+  for (unsigned int w = 0; w < n; w++) {
+    struct _Vertex* vertex = &t->vertices[w];
+    vertex->inDegree = g->vertices[w].outDegree;
+    if (g->vertices[w].inDegree > 0) {
+      _allocBlock(t, vertex, g->vertices[w].inDegree, 1);
+    }
+  }
+
+  /* Percorrendo as origens por ordem crescente, os adjacentes de cada vértice de 't' ficam logo ordenados */
+  for (unsigned int v = 0; v < n; v++) {
+    GraphAdjacents adj = GraphGetAdjacents(g, v);
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+      struct _Vertex* vertex = &t->vertices[adj.vertices[j]];
+      _adjacents(t, vertex)[vertex->outDegree] = v;
+      if (t->isWeighted) _weights(t, vertex)[vertex->outDegree] = adj.weights[j];
+      vertex->outDegree++;
+    }
+  }
+
+  return t;
 }
 
 // CHECKING
@@ -695,32 +1219,38 @@ int GraphRemoveEdge(Graph* g, unsigned int v, unsigned int w) {
 int GraphCheckInvariants(const Graph* g) {
   assert(g != NULL);
   
-  /* Verificar o tamanho da lista dos vértices */
-  if (g->numVertices != ListGetSize(g->verticesList)) {
-    return 0;
-  }
-
   /* Variáves que contêm os graus dos vértices */
   unsigned int sumOutDegree = 0;
   unsigned int sumInDegree = 0;
 
-  List* vertices = g->verticesList;
-  ListMoveToHead(vertices);
+  for (unsigned int i = 0; i < g->numVertices; i++) {
 
-  for (unsigned int i = 0; i < g->numVertices; ListMoveToNext(vertices), i++) {
-
-    struct _Vertex* v = ListGetCurrentItem(vertices);
+    struct _Vertex* v = &g->vertices[i];
 
     /* Atualizar as variáveis das somas */
     sumOutDegree += v->outDegree;
     sumInDegree += v->inDegree;
 
-    /* Verificar IDs dos vértices */
-    if (v->id > g->numVertices) {
+    /* Verificar IDs dos vértices (o vértice 'i' tem de estar na posição 'i' do array) */
+    if (v->id != i) {
       return 0;  // ID inválido
     }
 
   }
+
+  /* O índice das arestas, se existir, tem uma chave por cada adjacente guardado */
+  if (g->edgeIndex != NULL && g->edgeIndex->size != sumOutDegree) {
+    return 0;
+  }
+
+  /* As arestas incidentes guardadas de cada vértice, se existirem, são tantas quanto o seu grau de entrada */
+  if (g->incoming != NULL) {
+    for (unsigned int i = 0; i < g->numVertices; i++) {
+      if (g->incoming[i].outDegree != g->vertices[i].inDegree) {
+        return 0;
+      }
+    }
+  }
   
   if (GraphIsDigraph(g)) {
 
@@ -794,28 +1324,17 @@ void GraphDisplay(const Graph* g) {
   }
   printf("Vertices = %2d | Edges = %2d\n", g->numVertices, g->numEdges);
 
-  List* vertices = g->verticesList;
-  ListMoveToHead(vertices);
-  unsigned int i = 0;
-  for (; i < g->numVertices; ListMoveToNext(vertices), i++) {
+  for (unsigned int i = 0; i < g->numVertices; i++) {
     printf("%2d ->", i);
-    struct _Vertex* v = ListGetCurrentItem(vertices);
-    if (ListIsEmpty(v->edgesList)) {
-      printf("\n");
-    } else {
-      List* edges = v->edgesList;
-      unsigned int i = 0;
-      ListMoveToHead(edges);
-      for (; i < ListGetSize(edges); ListMoveToNext(edges), i++) {
-        struct _Edge* e = ListGetCurrentItem(edges);
-        if (g->isWeighted) {
-          printf("   %2d(%4.2f)", e->adjVertex, e->weight);
-        } else {
-          printf("   %2d", e->adjVertex);
-        }
+    GraphAdjacents adj = GraphGetAdjacents(g, i);
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+      if (g->isWeighted) {
+        printf("   %2d(%4.2f)", adj.vertices[j], adj.weights[j]);
+      } else {
+        printf("   %2d", adj.vertices[j]);
       }
-      printf("\n");
     }
+    printf("\n");
   }
   printf("---\n");
 }
@@ -823,17 +1342,15 @@ void GraphDisplay(const Graph* g) {
 void GraphListAdjacents(const Graph* g, unsigned int v) {
   printf("---\n");
 
-  unsigned int* array = GraphGetAdjacentsTo(g, v);
+  GraphAdjacents adj = GraphGetAdjacents(g, v);
 
-  printf("Vertex %d has %d adjacent vertices -> ", v, array[0]);
+  printf("Vertex %d has %d adjacent vertices -> ", v, adj.numAdjacents);
 
-  for (unsigned int i = 1; i <= array[0]; i++) {
-    printf("%d ", array[i]);
+  for (unsigned int i = 0; i < adj.numAdjacents; i++) {
+    printf("%d ", adj.vertices[i]);
   }
 
   printf("\n");
 
-  free(array);
-
   printf("---\n");
 }
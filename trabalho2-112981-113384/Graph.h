@@ -3,7 +3,7 @@
 //
 // Joaquim Madeira, Joao Manuel Rodrigues - June 2021, Nov 2023
 //
-// Graph - Using a list of adjacency lists representation
+// Graph - Using an array of adjacency lists representation
 //
 
 #ifndef _GRAPH_
@@ -11,6 +11,13 @@
 
 #include <stdio.h>
 
+//
+// All the functions taking a const Graph* only read the graph: they keep no
+// hidden state (such as list cursors) inside it, so any number of threads
+// may call them at the same time on the same graph, as long as no thread
+// is modifying it
+//
+
 typedef struct _GraphHeader Graph;
 
 Graph* GraphCreate(unsigned int numVertices, int isDigraph, int isWeighted);
@@ -52,6 +59,24 @@ unsigned int GraphGetMaxOutDegree(const Graph* g);
 
 // Vertices
 
+//
+// The adjacents of a vertex, read in place from the graph's own storage:
+// numAdjacents vertex indices, in increasing order, and the weights of the
+// corresponding edges (weights is NULL if the graph is not weighted)
+// Valid until the next modification of the graph: DO NOT FREE the arrays
+//
+typedef struct _GraphAdjacents {
+  unsigned int numAdjacents;
+  const unsigned int* vertices;
+  const double* weights;
+} GraphAdjacents;
+
+GraphAdjacents GraphGetAdjacents(const Graph* g, unsigned int v);
+
+//
+// Same information, copied into newly allocated arrays: element 0 stores
+// the number of adjacent vertices (the caller must free the array)
+//
 unsigned int* GraphGetAdjacentsTo(const Graph* g, unsigned int v);
 
 // Vertices distances
@@ -60,17 +85,17 @@ double* GraphGetDistancesToAdjacents(const Graph* g, unsigned int v);
 //
 // For a graph
 //
-unsigned int GraphGetVertexDegree(Graph* g, unsigned int v);
+unsigned int GraphGetVertexDegree(const Graph* g, unsigned int v);
 
 //
 // For a digraph
 //
-unsigned int GraphGetVertexOutDegree(Graph* g, unsigned int v);
+unsigned int GraphGetVertexOutDegree(const Graph* g, unsigned int v);
 
 //
 // For a digraph
 //
-unsigned int GraphGetVertexInDegree(Graph* g, unsigned int v);
+unsigned int GraphGetVertexInDegree(const Graph* g, unsigned int v);
 
 // Edges
 
@@ -79,8 +104,77 @@ int GraphAddEdge(Graph* g, unsigned int v, unsigned int w);
 int GraphAddWeightedEdge(Graph* g, unsigned int v, unsigned int w,
                          double weight);
 
+//
+// Adds the edges (src[i], dst[i]), with weight weights[i], for i < numEdges
+// weights must be NULL if, and only if, the graph is not weighted
+// Same result as adding them one by one, in order, with GraphAddEdge or
+// GraphAddWeightedEdge (repeated and already existing edges are ignored),
+// but the batch is sorted once and merged with the existing edges
+// returns the number of edges actually added
+//
+unsigned int GraphAddEdgesBatch(Graph* g, const unsigned int* src,
+                                const unsigned int* dst, const double* weights,
+                                size_t numEdges);
+
+//
+// returns 1 if the edge was removed, 0 if it did not exist
+//
 int GraphRemoveEdge(Graph* g, unsigned int v, unsigned int w);
 
+// Edge index
+//
+// An optional hash table of the edges, built from the current edges and then
+// kept up to date by every addition and removal: GraphHasEdge and
+// GraphGetEdgeWeight become O(1), and so does finding out that an edge to
+// add already exists, or that an edge to remove does not (removing an
+// existing edge still shifts the adjacents after it)
+// Without the index, both lookups binary search the adjacents of v
+//
+void GraphEnableEdgeIndex(Graph* g);
+
+void GraphDisableEdgeIndex(Graph* g);
+
+int GraphHasEdgeIndex(const Graph* g);
+
+int GraphHasEdge(const Graph* g, unsigned int v, unsigned int w);
+
+//
+// The weight of the edge (v, w) (1 if the graph is not weighted), or
+// INFINITY if there is no such edge
+//
+double GraphGetEdgeWeight(const Graph* g, unsigned int v, unsigned int w);
+
+// Incoming edges
+//
+// Optionally, a digraph also stores, for every vertex w, the sources of the
+// edges that reach w (built in O(V + E) and then kept up to date by every
+// addition and removal). In a graph, they are the adjacents of w
+//
+void GraphEnableIncomingEdges(Graph* g);
+
+void GraphDisableIncomingEdges(Graph* g);
+
+int GraphHasIncomingEdges(const Graph* g);
+
+//
+// The sources of the edges that reach w, read in place (as GraphGetAdjacents)
+// Only if GraphHasIncomingEdges(g)
+//
+GraphAdjacents GraphGetIncoming(const Graph* g, unsigned int w);
+
+//
+// Same information, copied into a newly allocated array: element 0 stores
+// the number of vertices (the caller must free the array)
+// Without the stored incoming edges, it goes over all the vertices
+//
+unsigned int* GraphGetIncomingTo(const Graph* g, unsigned int w);
+
+//
+// The digraph with every edge reversed, built in O(V + E)
+// (for a graph, a copy)
+//
+Graph* GraphTranspose(const Graph* g);
+
 // CHECKING
 
 int GraphCheckInvariants(const Graph* g);
@@ -0,0 +1,711 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Graph - Immutable compressed sparse row (CSR) representation
+//
+
+#include "GraphCSR.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define CSR_POSIX 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "Graph.h"
+#include "GraphFileParser.h"
+
+/* Representação CSR de um grafo -> apenas de leitura depois de construída */
+struct _GraphCSR {
+  int isDigraph;            /* É grafo orientado? 0 ou 1 */
+  int isComplete;           /* É completo? 0 ou 1 */
+  int isWeighted;           /* Tem custos nas suas arestas? 0 ou 1 */
+  unsigned int numVertices; /* Número de vértices */
+  unsigned int numEdges;    /* Número de arestas (como em Graph) */
+  unsigned int numArcs;     /* Número de entradas em 'adjacents' (2 * numEdges num grafo não orientado) */
+  unsigned int* offsets;    /* Os adjacentes de v estão nas posições [offsets[v], offsets[v+1]) */
+  unsigned int* adjacents;  /* Vértices adjacentes de todos os vértices, contíguos e ordenados */
+  double* weights;          /* Custos, paralelos a 'adjacents' (NULL se não for weighted) */
+  unsigned int* inDegree;   /* Grau de entrada de cada vértice */
+  void* snapshot;           /* Ficheiro binário onde estão os arrays, se foi carregado com GraphLoadSnapshot (senão NULL) */
+  size_t snapshotSize;      /* Tamanho desse ficheiro */
+  int snapshotIsMapped;     /* O ficheiro está mapeado em memória (1) ou foi lido para um bloco de memória (0)? */
+};
+
+/*
+  Formato dos ficheiros binários (snapshots), pensado para poder ser mapeado em memória e usado tal como está:
+    -> cabeçalho de SNAPSHOT_HEADER_SIZE bytes (struct _SnapshotHeader, com zeros no fim);
+    -> arrays offsets (numVertices + 1), inDegree (numVertices), adjacents (numArcs) e, se for weighted,
+       weights (numArcs), por esta ordem, cada um a começar num múltiplo de 8 bytes (com zeros entre eles).
+  O checksum é calculado sobre tudo o que vem depois do cabeçalho e, a seguir, sobre o próprio cabeçalho (com o
+  campo 'checksum' a zero), lidos como uma sequência de palavras de 64 bits.
+  Os bits de 'flags' não definidos abaixo e os bytes reservados no fim do cabeçalho têm de ser 0.
+  Os números são guardados pela ordem de bytes da máquina que escreveu o ficheiro (verificada com 'byteOrder').
+*/
+#define SNAPSHOT_MAGIC "AEDGRAPH"
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+#define SNAPSHOT_HEADER_SIZE 64
+
+#define SNAPSHOT_DIGRAPH 1u
+#define SNAPSHOT_COMPLETE 2u
+#define SNAPSHOT_WEIGHTED 4u
+#define SNAPSHOT_FLAGS (SNAPSHOT_DIGRAPH | SNAPSHOT_COMPLETE | SNAPSHOT_WEIGHTED)
+
+struct _SnapshotHeader {
+  char magic[8];            /* SNAPSHOT_MAGIC */
+  uint32_t version;         /* SNAPSHOT_VERSION */
+  uint32_t byteOrder;       /* SNAPSHOT_BYTE_ORDER */
+  uint32_t flags;           /* isDigraph, isComplete e isWeighted de _GraphHeader */
+  uint32_t numVertices;
+  uint32_t numEdges;
+  uint32_t numArcs;
+  uint64_t payloadSize;     /* Número de bytes depois do cabeçalho */
+  uint64_t checksum;        /* Checksum desses bytes e do cabeçalho */
+};
+
+/* Arredondar para o múltiplo de 8 seguinte */
+#define ALIGN8(n) (((n) + 7) & ~(uint64_t)7)
+
+#define FNV_OFFSET 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+/* Acrescentar 'size' bytes (múltiplo de 8) ao checksum (FNV-1a, palavra a palavra) */
+static uint64_t _checksum(uint64_t hash, const void* data, size_t size) {
+  const unsigned char* p = (const unsigned char*)data;
+  for (size_t i = 0; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, p + i, 8);
+    hash = (hash ^ word) * FNV_PRIME;
+  }
+  return hash;
+}
+
+/* Acrescentar ao checksum o bloco do cabeçalho, com o campo 'checksum' a zero */
+static uint64_t _headerChecksum(uint64_t hash, const unsigned char* block) {
+  unsigned char copy[SNAPSHOT_HEADER_SIZE];
+  memcpy(copy, block, SNAPSHOT_HEADER_SIZE);
+  memset(copy + offsetof(struct _SnapshotHeader, checksum), 0, sizeof(uint64_t));
+  return _checksum(hash, copy, SNAPSHOT_HEADER_SIZE);
+}
+
+/* Alocar a estrutura e os seus arrays para 'numVertices' vértices e 'numArcs' entradas de adjacência */
+static GraphCSR* _create(unsigned int numVertices, unsigned int numArcs,
+                         int isDigraph, int isWeighted) {
+  GraphCSR* g = (GraphCSR*)malloc(sizeof(struct _GraphCSR));
+  if (g == NULL) abort();
+
+  g->isDigraph = isDigraph;
+  g->isComplete = 0;
+  g->isWeighted = isWeighted;
+  g->numVertices = numVertices;
+  g->numEdges = 0;
+  g->numArcs = numArcs;
+
+  /* "+ 1" nos malloc's para nunca pedir 0 bytes */
+  g->offsets = (unsigned int*)malloc((numVertices + 1) * sizeof(unsigned int));
+  g->adjacents = (unsigned int*)malloc((numArcs + 1) * sizeof(unsigned int));
+  g->weights = isWeighted ? (double*)malloc((numArcs + 1) * sizeof(double)) : NULL;
+  g->inDegree = (unsigned int*)calloc(numVertices + 1, sizeof(unsigned int));
+
+  if (g->offsets == NULL || g->adjacents == NULL || g->inDegree == NULL ||
+      (isWeighted && g->weights == NULL)) {
+    abort();
+  }
+
+  g->offsets[0] = 0;
+
+  g->snapshot = NULL;
+  g->snapshotSize = 0;
+  g->snapshotIsMapped = 0;
+
+  return g;
+}
+
+/* Calcular o grau de entrada de cada vértice a partir dos arrays de adjacência */
+static void _computeInDegrees(GraphCSR* g) {
+  for (unsigned int i = 0; i < g->numVertices; i++) {
+    g->inDegree[i] = 0;
+  }
+  for (unsigned int k = 0; k < g->offsets[g->numVertices]; k++) {
+    g->inDegree[g->adjacents[k]]++;
+  }
+}
+
+
+/* Construir a representação CSR de um grafo já existente */
+GraphCSR* GraphCSRCreate(const Graph* g) {
+  assert(g != NULL);
+
+  unsigned int numVertices = GraphGetNumVertices(g);
+  unsigned int numEdges = GraphGetNumEdges(g);
+
+  /* Num grafo não orientado, cada aresta aparece nas listas dos seus dois vértices */
+  unsigned int numArcs = GraphIsDigraph(g) ? numEdges : 2 * numEdges;
+
+  GraphCSR* csr = _create(numVertices, numArcs, GraphIsDigraph(g), GraphIsWeighted(g));
+  csr->isComplete = GraphIsComplete(g);
+  csr->numEdges = numEdges;
+
+  /* Copiar, vértice a vértice, os adjacentes (já ordenados) para posições consecutivas */
+  unsigned int pos = 0;
+  for (unsigned int v = 0; v < numVertices; v++) {
+    GraphAdjacents adj = GraphGetAdjacents(g, v);
+
+    assert(pos + adj.numAdjacents <= numArcs);
+
+    if (adj.numAdjacents > 0) {
+      memcpy(&csr->adjacents[pos], adj.vertices, adj.numAdjacents * sizeof(unsigned int));
+      if (csr->isWeighted) {
+        memcpy(&csr->weights[pos], adj.weights, adj.numAdjacents * sizeof(double));
+      }
+    }
+
+    pos += adj.numAdjacents;
+    csr->offsets[v + 1] = pos;
+  }
+
+  assert(pos == numArcs);
+
+  _computeInDegrees(csr);
+
+  return csr;
+}
+
+
+/*
+  Construir a representação CSR a partir de uma lista de arcos (src[i] -> dst[i], com custo w[i]):
+    1 - ordenação por contagem (estável) pelo vértice de destino;
+    2 - ordenação por contagem (estável) pelo vértice de origem, que define os offsets;
+    3 - eliminação dos arcos repetidos, mantendo o primeiro (como faz GraphAddEdge).
+  Tudo em O(V + E), sem nenhuma inserção ordenada.
+*/
+static void _buildFromArcs(GraphCSR* g, const unsigned int* src,
+                           const unsigned int* dst, const double* w,
+                           unsigned int numArcs) {
+  unsigned int n = g->numVertices;
+
+  unsigned int* next = (unsigned int*)calloc(n + 1, sizeof(unsigned int));
+  unsigned int* byDst = (unsigned int*)malloc((numArcs + 1) * sizeof(unsigned int));
+  if (next == NULL || byDst == NULL) abort();
+
+  /* 1 - Contar, somas prefixas e espalhar os índices dos arcos por vértice de destino */
+  for (unsigned int i = 0; i < numArcs; i++) {
+    next[dst[i] + 1]++;
+  }
+  for (unsigned int v = 0; v < n; v++) {
+    next[v + 1] += next[v];
+  }
+  for (unsigned int i = 0; i < numArcs; i++) {
+    byDst[next[dst[i]]++] = i;
+  }
+
+  /* 2 - O mesmo, por vértice de origem, escrevendo já nos arrays finais */
+  for (unsigned int v = 0; v <= n; v++) {
+    g->offsets[v] = 0;
+  }
+  for (unsigned int i = 0; i < numArcs; i++) {
+    g->offsets[src[i] + 1]++;
+  }
+  for (unsigned int v = 0; v < n; v++) {
+    g->offsets[v + 1] += g->offsets[v];
+    next[v] = g->offsets[v];
+  }
+  for (unsigned int k = 0; k < numArcs; k++) {
+    unsigned int i = byDst[k];
+    unsigned int pos = next[src[i]]++;
+    g->adjacents[pos] = dst[i];
+    if (g->isWeighted) {
+      g->weights[pos] = w[i];
+    }
+  }
+
+  /* 3 - Compactar cada linha, descartando os adjacentes repetidos (estão consecutivos) */
+  unsigned int write = 0;
+  unsigned int start = 0;
+  for (unsigned int v = 0; v < n; v++) {
+    unsigned int end = g->offsets[v + 1];
+    for (unsigned int k = start; k < end; k++) {
+      if (k > start && g->adjacents[k] == g->adjacents[k - 1]) {
+        continue;
+      }
+      g->adjacents[write] = g->adjacents[k];
+      if (g->isWeighted) {
+        g->weights[write] = g->weights[k];
+      }
+      write++;
+    }
+    start = end;
+    g->offsets[v + 1] = write;
+  }
+
+  g->numArcs = write;
+  g->numEdges = g->isDigraph ? write : write / 2;
+
+  _computeInDegrees(g);
+
+  free(next);
+  free(byDst);
+}
+
+
+/* Ler a informação de um grafo, diretamente para a representação CSR, a partir de um ficheiro de texto */
+GraphCSR* GraphCSRFromFile(FILE* f) {
+  assert(f != NULL);
+
+  /* Ler o ficheiro todo para arrays com as suas arestas, já sem os lacetes (ver GraphFileParser.c) */
+  GraphFileData* data = GraphFileParse(f);
+  if (data == NULL) return NULL;
+
+  unsigned int numArcs = data->isDigraph ? data->numEdges : 2 * data->numEdges;
+
+  GraphCSR* g = _create(data->numVertices, numArcs, data->isDigraph, data->isWeighted);
+
+  if (data->isDigraph) {
+    _buildFromArcs(g, data->src, data->dst, data->weights, numArcs);
+  } else {
+    /* Num grafo não orientado, cada aresta dá origem a dois arcos */
+    unsigned int* src = (unsigned int*)malloc(((size_t)numArcs + 1) * sizeof(unsigned int));
+    unsigned int* dst = (unsigned int*)malloc(((size_t)numArcs + 1) * sizeof(unsigned int));
+    double* w = data->isWeighted ? (double*)malloc(((size_t)numArcs + 1) * sizeof(double)) : NULL;
+    if (src == NULL || dst == NULL || (data->isWeighted && w == NULL)) abort();
+
+    for (unsigned int i = 0; i < data->numEdges; i++) {
+      src[2 * i] = data->src[i];
+      dst[2 * i] = data->dst[i];
+      src[2 * i + 1] = data->dst[i];
+      dst[2 * i + 1] = data->src[i];
+      if (w != NULL) {
+        w[2 * i] = w[2 * i + 1] = data->weights[i];
+      }
+    }
+
+    _buildFromArcs(g, src, dst, w, numArcs);
+
+    free(src);
+    free(dst);
+    free(w);
+  }
+
+  GraphFileDataDestroy(&data);
+
+  return g;
+}
+
+
+/* Destruir a representação CSR */
+void GraphCSRDestroy(GraphCSR** p) {
+  assert(*p != NULL);
+  GraphCSR* g = *p;
+
+  if (g->snapshot != NULL) {
+    /* Os arrays estão dentro do snapshot */
+#ifdef CSR_POSIX
+    if (g->snapshotIsMapped) {
+      munmap(g->snapshot, g->snapshotSize);
+    } else {
+      free(g->snapshot);
+    }
+#else
+    free(g->snapshot);
+#endif
+  } else {
+    free(g->offsets);
+    free(g->adjacents);
+    free(g->weights);
+    free(g->inDegree);
+  }
+  free(g);
+
+  *p = NULL;
+}
+
+// BINARY SNAPSHOTS
+
+/* Escrever um array seguido dos zeros que completam um múltiplo de 8 bytes, atualizando o checksum */
+static int _writeSection(FILE* f, const void* data, size_t size, uint64_t* hash) {
+  static const unsigned char zeros[8] = {0};
+  size_t whole = size & ~(size_t)7;
+  size_t rest = size - whole;
+
+  if (size > 0 && fwrite(data, 1, size, f) != size) return 0;
+  *hash = _checksum(*hash, data, whole);
+
+  if (rest > 0) {
+    unsigned char last[8] = {0};
+    memcpy(last, (const unsigned char*)data + whole, rest);
+    if (fwrite(zeros, 1, 8 - rest, f) != 8 - rest) return 0;
+    *hash = _checksum(*hash, last, 8);
+  }
+
+  return 1;
+}
+
+/* Guardar a representação CSR num ficheiro binário: devolve 1 em caso de sucesso e 0 caso contrário */
+int GraphCSRSave(const GraphCSR* g, const char* fileName) {
+  assert(g != NULL && fileName != NULL);
+
+  FILE* f = fopen(fileName, "wb");
+  if (f == NULL) {
+    perror("fopen");
+    return 0;
+  }
+
+  struct _SnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, 8);
+  header.version = SNAPSHOT_VERSION;
+  header.byteOrder = SNAPSHOT_BYTE_ORDER;
+  header.flags = (g->isDigraph ? SNAPSHOT_DIGRAPH : 0) |
+                 (g->isComplete ? SNAPSHOT_COMPLETE : 0) |
+                 (g->isWeighted ? SNAPSHOT_WEIGHTED : 0);
+  header.numVertices = g->numVertices;
+  header.numEdges = g->numEdges;
+  header.numArcs = g->numArcs;
+
+  /* O cabeçalho é escrito primeiro sem checksum, e reescrito no fim, já com ele */
+  unsigned char block[SNAPSHOT_HEADER_SIZE] = {0};
+  int ok = fwrite(block, 1, SNAPSHOT_HEADER_SIZE, f) == SNAPSHOT_HEADER_SIZE;
+
+  uint64_t hash = FNV_OFFSET;
+  ok = ok && _writeSection(f, g->offsets, ((size_t)g->numVertices + 1) * sizeof(unsigned int), &hash);
+  ok = ok && _writeSection(f, g->inDegree, (size_t)g->numVertices * sizeof(unsigned int), &hash);
+  ok = ok && _writeSection(f, g->adjacents, (size_t)g->numArcs * sizeof(unsigned int), &hash);
+  if (g->isWeighted) {
+    ok = ok && _writeSection(f, g->weights, (size_t)g->numArcs * sizeof(double), &hash);
+  }
+
+  long end = ftell(f);
+  header.payloadSize = (uint64_t)(end - SNAPSHOT_HEADER_SIZE);
+  memcpy(block, &header, sizeof(header));
+  header.checksum = _headerChecksum(hash, block);
+  memcpy(block, &header, sizeof(header));
+
+  ok = ok && end > 0 && fseek(f, 0, SEEK_SET) == 0;
+  ok = ok && fwrite(block, 1, SNAPSHOT_HEADER_SIZE, f) == SNAPSHOT_HEADER_SIZE;
+
+  if (fclose(f) != 0) ok = 0;
+
+  if (!ok) {
+    fprintf(stderr, "Error writing snapshot %s\n", fileName);
+  }
+  return ok;
+}
+
+/* Guardar um grafo num ficheiro binário, através da sua representação CSR */
+int GraphSave(const Graph* g, const char* fileName) {
+  GraphCSR* csr = GraphCSRCreate(g);
+  int ok = GraphCSRSave(csr, fileName);
+  GraphCSRDestroy(&csr);
+  return ok;
+}
+
+/* Ler o ficheiro todo: mapeado em memória, se possível, ou para um bloco de memória (os erros são reportados aqui) */
+static void* _loadFile(const char* fileName, size_t* size, int* isMapped) {
+  FILE* f = fopen(fileName, "rb");
+  if (f == NULL) {
+    perror(fileName);
+    return NULL;
+  }
+
+  void* data = NULL;
+  *isMapped = 0;
+
+#ifdef CSR_POSIX
+  struct stat st;
+  if (fstat(fileno(f), &st) == 0 && st.st_size >= SNAPSHOT_HEADER_SIZE) {
+    /* MAP_SHARED: processos diferentes que carreguem o mesmo snapshot partilham as mesmas páginas */
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fileno(f), 0);
+    if (data == MAP_FAILED) {
+      data = NULL;
+    } else {
+      *size = (size_t)st.st_size;
+      *isMapped = 1;
+    }
+  }
+#endif
+
+  if (data == NULL && fseek(f, 0, SEEK_END) == 0) {
+    long length = ftell(f);
+    if (length >= SNAPSHOT_HEADER_SIZE && fseek(f, 0, SEEK_SET) == 0) {
+      data = malloc((size_t)length);
+      if (data == NULL) abort();
+      if (fread(data, 1, (size_t)length, f) != (size_t)length) {
+        free(data);
+        data = NULL;
+      } else {
+        *size = (size_t)length;
+      }
+    }
+  }
+
+  fclose(f);
+
+  if (data == NULL) {
+    fprintf(stderr, "Error reading snapshot %s: too short or unreadable\n", fileName);
+  }
+  return data;
+}
+
+/* Libertar o que _loadFile devolveu */
+static void _unloadFile(void* data, size_t size, int isMapped) {
+#ifdef CSR_POSIX
+  if (isMapped) {
+    munmap(data, size);
+    return;
+  }
+#endif
+  (void)size;
+  (void)isMapped;
+  free(data);
+}
+
+/*
+  Verificar a consistência dos arrays de um snapshot, em O(V + E), para que nenhum acesso possa sair deles:
+    -> os offsets começam em 0, nunca diminuem e terminam em numArcs;
+    -> os adjacentes de cada vértice são vértices válidos, por ordem estritamente crescente;
+    -> o grau de entrada guardado de cada vértice é o número de vezes que ele aparece como adjacente.
+  Devolve NULL, ou a descrição do primeiro problema encontrado.
+*/
+static const char* _checkArrays(const uint32_t* offsets, const uint32_t* inDegree,
+                                const uint32_t* adjacents, uint32_t n, uint32_t m) {
+  if (offsets[0] != 0 || offsets[n] != m) {
+    return "corrupted offsets";
+  }
+  for (uint32_t v = 0; v < n; v++) {
+    if (offsets[v] > offsets[v + 1]) {
+      return "corrupted offsets";
+    }
+  }
+
+  unsigned int* count = (unsigned int*)calloc((size_t)n + 1, sizeof(unsigned int));
+  if (count == NULL) abort();
+
+  const char* error = NULL;
+  for (uint32_t v = 0; v < n && error == NULL; v++) {
+    for (uint32_t k = offsets[v]; k < offsets[v + 1]; k++) {
+      uint32_t w = adjacents[k];
+      if (w >= n || (k > offsets[v] && w <= adjacents[k - 1])) {
+        error = "corrupted adjacents";
+        break;
+      }
+      count[w]++;
+    }
+  }
+  for (uint32_t v = 0; v < n && error == NULL; v++) {
+    if (count[v] != inDegree[v]) {
+      error = "corrupted in-degrees";
+    }
+  }
+
+  free(count);
+  return error;
+}
+
+/* Os 'size' bytes em 'data' são todos 0? */
+static int _isZero(const unsigned char* data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    if (data[i] != 0) return 0;
+  }
+  return 1;
+}
+
+/*
+  Carregar um ficheiro binário criado por GraphCSRSave ou GraphSave
+  Os arrays são usados diretamente a partir do ficheiro mapeado em memória, sem nenhuma cópia; são apenas
+  percorridos uma vez, para verificar a sua consistência (e o checksum, se for pedido)
+*/
+GraphCSR* GraphLoadSnapshot(const char* fileName, int verifyChecksum) {
+  assert(fileName != NULL);
+
+  size_t size = 0;
+  int isMapped = 0;
+  unsigned char* data = (unsigned char*)_loadFile(fileName, &size, &isMapped);
+  if (data == NULL) {
+    return NULL;
+  }
+
+  struct _SnapshotHeader header;
+  memcpy(&header, data, sizeof(header));
+
+  /* Validar o cabeçalho e o tamanho de cada array */
+  uint64_t n = header.numVertices;
+  uint64_t m = header.numArcs;
+  int digraph = (header.flags & SNAPSHOT_DIGRAPH) != 0;
+  int weighted = (header.flags & SNAPSHOT_WEIGHTED) != 0;
+
+  uint64_t offsetsPos = SNAPSHOT_HEADER_SIZE;
+  uint64_t inDegreePos = offsetsPos + ALIGN8((n + 1) * sizeof(uint32_t));
+  uint64_t adjacentsPos = inDegreePos + ALIGN8(n * sizeof(uint32_t));
+  uint64_t weightsPos = adjacentsPos + ALIGN8(m * sizeof(uint32_t));
+  uint64_t endPos = weightsPos + (weighted ? m * sizeof(double) : 0);
+
+  const char* error = NULL;
+  if (memcmp(header.magic, SNAPSHOT_MAGIC, 8) != 0) {
+    error = "not a graph snapshot";
+  } else if (header.version != SNAPSHOT_VERSION) {
+    error = "unsupported version";
+  } else if (header.byteOrder != SNAPSHOT_BYTE_ORDER) {
+    error = "written on a machine with a different byte order";
+  } else if ((header.flags & ~SNAPSHOT_FLAGS) != 0) {
+    error = "unknown flags";
+  } else if (!_isZero(data + sizeof(header), SNAPSHOT_HEADER_SIZE - sizeof(header))) {
+    error = "corrupted header";
+  } else if (sizeof(unsigned int) != sizeof(uint32_t) ||
+             endPos != size || header.payloadSize != size - SNAPSHOT_HEADER_SIZE) {
+    error = "wrong size";
+  } else if (m != (digraph ? 1u : 2u) * (uint64_t)header.numEdges) {
+    error = "wrong number of edges";
+  } else if ((header.flags & SNAPSHOT_COMPLETE) && m != n * (n > 0 ? n - 1 : 0)) {
+    error = "wrong number of edges for a complete graph";
+  } else if (verifyChecksum &&
+             _headerChecksum(_checksum(FNV_OFFSET, data + SNAPSHOT_HEADER_SIZE, header.payloadSize), data) !=
+                 header.checksum) {
+    error = "wrong checksum";
+  }
+
+  if (error == NULL) {
+    /* Mesmo sem checksum, um ficheiro truncado ou corrompido nunca é aceite */
+    error = _checkArrays((const uint32_t*)(data + offsetsPos), (const uint32_t*)(data + inDegreePos),
+                         (const uint32_t*)(data + adjacentsPos), header.numVertices, header.numArcs);
+  }
+
+  if (error != NULL) {
+    fprintf(stderr, "Error reading snapshot %s: %s\n", fileName, error);
+    _unloadFile(data, size, isMapped);
+    return NULL;
+  }
+
+  GraphCSR* g = (GraphCSR*)malloc(sizeof(struct _GraphCSR));
+  if (g == NULL) abort();
+
+  g->isDigraph = digraph;
+  g->isComplete = (header.flags & SNAPSHOT_COMPLETE) != 0;
+  g->isWeighted = weighted;
+  g->numVertices = header.numVertices;
+  g->numEdges = header.numEdges;
+  g->numArcs = header.numArcs;
+
+  /* Os arrays apontam para dentro do ficheiro (só de leitura, se estiver mapeado) */
+  g->offsets = (unsigned int*)(data + offsetsPos);
+  g->inDegree = (unsigned int*)(data + inDegreePos);
+  g->adjacents = (unsigned int*)(data + adjacentsPos);
+  g->weights = weighted ? (double*)(data + weightsPos) : NULL;
+
+  g->snapshot = data;
+  g->snapshotSize = size;
+  g->snapshotIsMapped = isMapped;
+
+  return g;
+}
+
+// Graph
+
+int GraphCSRIsDigraph(const GraphCSR* g) { return g->isDigraph; }
+
+int GraphCSRIsComplete(const GraphCSR* g) { return g->isComplete; }
+
+int GraphCSRIsWeighted(const GraphCSR* g) { return g->isWeighted; }
+
+unsigned int GraphCSRGetNumVertices(const GraphCSR* g) { return g->numVertices; }
+
+unsigned int GraphCSRGetNumEdges(const GraphCSR* g) { return g->numEdges; }
+
+// Vertices
+
+unsigned int GraphCSRGetVertexOutDegree(const GraphCSR* g, unsigned int v) {
+  assert(v < g->numVertices);
+  return g->offsets[v + 1] - g->offsets[v];
+}
+
+unsigned int GraphCSRGetVertexInDegree(const GraphCSR* g, unsigned int v) {
+  assert(v < g->numVertices);
+  return g->inDegree[v];
+}
+
+const unsigned int* GraphCSRGetAdjacentsTo(const GraphCSR* g, unsigned int v) {
+  assert(v < g->numVertices);
+  return g->adjacents + g->offsets[v];
+}
+
+const double* GraphCSRGetDistancesToAdjacents(const GraphCSR* g,
+                                              unsigned int v) {
+  assert(v < g->numVertices);
+  if (g->weights == NULL) return NULL;
+  return g->weights + g->offsets[v];
+}
+
+GraphAdjacents GraphCSRGetAdjacents(const GraphCSR* g, unsigned int v) {
+  assert(v < g->numVertices);
+
+  GraphAdjacents adj;
+  adj.numAdjacents = g->offsets[v + 1] - g->offsets[v];
+  adj.vertices = g->adjacents + g->offsets[v];
+  adj.weights = (g->weights != NULL) ? g->weights + g->offsets[v] : NULL;
+  return adj;
+}
+
+// DISPLAYING on the console
+/* Imprimir os dados relativos a um grafo, no mesmo formato que GraphDisplay */
+void GraphCSRDisplay(const GraphCSR* g) {
+  printf("---\n");
+  if (g->isWeighted) {
+    printf("Weighted ");
+  }
+  if (g->isComplete) {
+    printf("COMPLETE ");
+  }
+
+  unsigned int maxDegree = 0;
+  for (unsigned int v = 0; v < g->numVertices; v++) {
+    if (GraphCSRGetVertexOutDegree(g, v) > maxDegree) {
+      maxDegree = GraphCSRGetVertexOutDegree(g, v);
+    }
+  }
+
+  if (g->isDigraph) {
+    printf("Digraph\n");
+    printf("Max Out-Degree = %d\n", maxDegree);
+  } else {
+    printf("Graph\n");
+    printf("Max Degree = %d\n", maxDegree);
+  }
+  printf("Vertices = %2d | Edges = %2d\n", g->numVertices, g->numEdges);
+
+  for (unsigned int v = 0; v < g->numVertices; v++) {
+    printf("%2d ->", v);
+    for (unsigned int k = g->offsets[v]; k < g->offsets[v + 1]; k++) {
+      if (g->isWeighted) {
+        printf("   %2d(%4.2f)", g->adjacents[k], g->weights[k]);
+      } else {
+        printf("   %2d", g->adjacents[k]);
+      }
+    }
+    printf("\n");
+  }
+  printf("---\n");
+}
+
+void GraphCSRListAdjacents(const GraphCSR* g, unsigned int v) {
+  printf("---\n");
+
+  unsigned int numAdjacents = GraphCSRGetVertexOutDegree(g, v);
+  const unsigned int* adjacents = GraphCSRGetAdjacentsTo(g, v);
+
+  printf("Vertex %d has %d adjacent vertices -> ", v, numAdjacents);
+
+  for (unsigned int i = 0; i < numAdjacents; i++) {
+    printf("%d ", adjacents[i]);
+  }
+
+  printf("\n");
+
+  printf("---\n");
+}
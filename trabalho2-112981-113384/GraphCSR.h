@@ -0,0 +1,95 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Graph - Immutable compressed sparse row (CSR) representation
+//
+// The adjacents of vertex v are stored contiguously, sorted by vertex index,
+// in positions [offsets[v], offsets[v+1]) of a single array shared by all
+// vertices. Built once, from a Graph or directly from a file, and then only
+// read.
+//
+
+#ifndef _GRAPH_CSR_
+#define _GRAPH_CSR_
+
+#include <stdio.h>
+
+#include "Graph.h"
+
+typedef struct _GraphCSR GraphCSR;
+
+GraphCSR* GraphCSRCreate(const Graph* g);
+
+GraphCSR* GraphCSRFromFile(FILE* f);
+
+void GraphCSRDestroy(GraphCSR** p);
+
+// Graph
+
+int GraphCSRIsDigraph(const GraphCSR* g);
+
+int GraphCSRIsComplete(const GraphCSR* g);
+
+int GraphCSRIsWeighted(const GraphCSR* g);
+
+unsigned int GraphCSRGetNumVertices(const GraphCSR* g);
+
+unsigned int GraphCSRGetNumEdges(const GraphCSR* g);
+
+// Vertices
+
+unsigned int GraphCSRGetVertexOutDegree(const GraphCSR* g, unsigned int v);
+
+//
+// For an undirected graph, the in-degree is the vertex degree
+//
+unsigned int GraphCSRGetVertexInDegree(const GraphCSR* g, unsigned int v);
+
+//
+// returns a pointer to the GraphCSRGetVertexOutDegree(g, v) adjacent vertices
+// of v, sorted by index
+// the array belongs to the GraphCSR: DO NOT FREE IT
+//
+const unsigned int* GraphCSRGetAdjacentsTo(const GraphCSR* g, unsigned int v);
+
+//
+// returns a pointer to the distances to the adjacent vertices of v, in the
+// same order as GraphCSRGetAdjacentsTo, or NULL if the graph is not weighted
+// the array belongs to the GraphCSR: DO NOT FREE IT
+//
+const double* GraphCSRGetDistancesToAdjacents(const GraphCSR* g,
+                                              unsigned int v);
+
+//
+// Both of the above, as a GraphAdjacents (see Graph.h)
+//
+GraphAdjacents GraphCSRGetAdjacents(const GraphCSR* g, unsigned int v);
+
+// BINARY SNAPSHOTS
+//
+// A snapshot is a versioned, checksummed binary file holding the CSR arrays
+// exactly as they are kept in memory. Loading it maps the file into memory
+// and uses the arrays in place, read-only, without any parsing, so several
+// processes loading the same snapshot share the same pages.
+//
+// The save functions return 1 on success and 0 on failure.
+// GraphLoadSnapshot returns NULL on failure. It always checks, in O(V + E),
+// that the arrays are consistent (offsets, adjacents and in-degrees), so a
+// truncated or corrupted file is never accepted, and that the header has no
+// unknown flags. The checksum, which covers the header and the arrays, is only
+// verified if verifyChecksum is not 0.
+//
+
+int GraphCSRSave(const GraphCSR* g, const char* fileName);
+
+int GraphSave(const Graph* g, const char* fileName);
+
+GraphCSR* GraphLoadSnapshot(const char* fileName, int verifyChecksum);
+
+// DISPLAYING on the console
+
+void GraphCSRDisplay(const GraphCSR* g);
+
+void GraphCSRListAdjacents(const GraphCSR* g, unsigned int v);
+
+#endif  // _GRAPH_CSR_
@@ -0,0 +1,231 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Longest paths and critical path of a (weighted) DAG
+//
+
+#include "GraphCriticalPath.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Graph.h"
+#include "GraphTopologicalSorting.h"
+#include "instrumentation.h"
+
+struct _GraphCriticalPath {
+  unsigned int numVertices;
+  double length;            /* Duração de todo o escalonamento */
+  double* earliest;         /* Início mais cedo de cada vértice */
+  double* latest;           /* Início mais tarde de cada vértice */
+  unsigned int* path;       /* Um caminho mais longo */
+  unsigned int pathLength;  /* Número de vértices desse caminho */
+};
+
+/* Definir as macros a serem usadas para a análise da complexidade */
+#define VERTEX_ITER 0
+#define EDGE_ITER 1
+
+/* Vértice sem predecessor no caminho mais longo */
+#define NO_VERTEX ((unsigned int)-1)
+
+/* Custo da aresta j dos adjacentes 'adj' (1 se o grafo não for weighted) */
+static double _weight(const GraphAdjacents* adj, unsigned int j) {
+  return (adj->weights != NULL) ? adj->weights[j] : 1.0;
+}
+
+
+GraphCriticalPath* GraphCriticalPathCompute(const Graph* g, const GraphTopoSort* t) {
+  assert(g != NULL && GraphIsDigraph(g) == 1);
+  assert(t != NULL);
+
+  const unsigned int* order = GraphTopoSortGetSequence(t);
+  if (order == NULL) return NULL;
+
+  unsigned int n = GraphGetNumVertices(g);
+
+  GraphCriticalPath* p = (GraphCriticalPath*)malloc(sizeof(struct _GraphCriticalPath));
+  if (p == NULL) abort();
+
+  /* "+ 1" para nunca pedir 0 bytes */
+  p->numVertices = n;
+  p->earliest = (double*)malloc((n + 1) * sizeof(double));
+  p->latest = (double*)malloc((n + 1) * sizeof(double));
+  unsigned int* predecessor = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  if (p->earliest == NULL || p->latest == NULL || predecessor == NULL) abort();
+
+  for (unsigned int v = 0; v < n; v++) {
+    p->earliest[v] = 0.0;
+    predecessor[v] = NO_VERTEX;
+  }
+
+  /* Inícios mais cedo: pela ordem topológica, cada vértice já tem o valor final quando é visitado */
+  p->length = 0.0;
+  unsigned int last = NO_VERTEX;
+  for (unsigned int k = 0; k < n; k++) {
+    unsigned int v = order[k];
+    InstrInc(VERTEX_ITER);
+
+    if (last == NO_VERTEX || p->earliest[v] > p->length) {
+      p->length = p->earliest[v];
+      last = v;
+    }
+
+    GraphAdjacents adj = GraphGetAdjacents(g, v);
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+      unsigned int w = adj.vertices[j];
+      InstrInc(EDGE_ITER);
+
+      double start = p->earliest[v] + _weight(&adj, j);
+      if (start > p->earliest[w]) {
+        p->earliest[w] = start;
+        predecessor[w] = v;
+      }
+    }
+  }
+
+  /* Inícios mais tarde: pela ordem inversa, a partir do fim do escalonamento */
+  for (unsigned int k = n; k > 0; k--) {
+    unsigned int v = order[k - 1];
+    InstrInc(VERTEX_ITER);
+
+    double latest = p->length;
+    GraphAdjacents adj = GraphGetAdjacents(g, v);
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+      InstrInc(EDGE_ITER);
+
+      double start = p->latest[adj.vertices[j]] - _weight(&adj, j);
+      if (start < latest) {
+        latest = start;
+      }
+    }
+    p->latest[v] = latest;
+  }
+
+  /* O caminho crítico acaba no vértice que começa mais tarde, e é percorrido de trás para a frente */
+  p->pathLength = 0;
+  for (unsigned int v = last; v != NO_VERTEX; v = predecessor[v]) {
+    p->pathLength++;
+  }
+
+  p->path = (unsigned int*)malloc((p->pathLength + 1) * sizeof(unsigned int));
+  if (p->path == NULL) abort();
+
+  unsigned int k = p->pathLength;
+  for (unsigned int v = last; v != NO_VERTEX; v = predecessor[v]) {
+    p->path[--k] = v;
+  }
+
+  free(predecessor);
+
+  return p;
+}
+
+
+void GraphCriticalPathDestroy(GraphCriticalPath** p) {
+  assert(*p != NULL);
+
+  GraphCriticalPath* aux = *p;
+
+  free(aux->earliest);
+  free(aux->latest);
+  free(aux->path);
+
+  free(*p);
+  *p = NULL;
+}
+
+
+double GraphCriticalPathGetLength(const GraphCriticalPath* p) {
+  assert(p != NULL);
+  return p->length;
+}
+
+double GraphCriticalPathGetEarliestStart(const GraphCriticalPath* p, unsigned int v) {
+  assert(p != NULL && v < p->numVertices);
+  return p->earliest[v];
+}
+
+double GraphCriticalPathGetLatestStart(const GraphCriticalPath* p, unsigned int v) {
+  assert(p != NULL && v < p->numVertices);
+  return p->latest[v];
+}
+
+double GraphCriticalPathGetSlack(const GraphCriticalPath* p, unsigned int v) {
+  assert(p != NULL && v < p->numVertices);
+  return p->latest[v] - p->earliest[v];
+}
+
+const unsigned int* GraphCriticalPathGetPath(const GraphCriticalPath* p, unsigned int* length) {
+  assert(p != NULL && length != NULL);
+  *length = p->pathLength;
+  return p->path;
+}
+
+
+void GraphCriticalPathDisplay(const GraphCriticalPath* p) {
+  assert(p != NULL);
+
+  printf("Length = %.2f\n", p->length);
+  printf("Vertex | Earliest | Latest | Slack\n");
+  for (unsigned int v = 0; v < p->numVertices; v++) {
+    printf("%6u | %8.2f | %6.2f | %5.2f\n", v, p->earliest[v], p->latest[v], p->latest[v] - p->earliest[v]);
+  }
+
+  printf("Critical path:");
+  for (unsigned int k = 0; k < p->pathLength; k++) {
+    printf(" %u", p->path[k]);
+  }
+  printf("\n");
+}
+
+
+/* Distâncias a partir de 'source', pela ordem topológica: 'longest' escolhe entre o caminho mais curto e o mais longo */
+static double* _distances(const Graph* g, const GraphTopoSort* t, unsigned int source, int longest) {
+  assert(g != NULL && GraphIsDigraph(g) == 1);
+  assert(source < GraphGetNumVertices(g));
+
+  const unsigned int* order = GraphTopoSortGetSequence(t);
+  assert(order != NULL);
+
+  unsigned int n = GraphGetNumVertices(g);
+  double unreachable = longest ? -INFINITY : INFINITY;
+
+  double* distance = (double*)malloc((n + 1) * sizeof(double));
+  if (distance == NULL) abort();
+
+  for (unsigned int v = 0; v < n; v++) {
+    distance[v] = unreachable;
+  }
+  distance[source] = 0.0;
+
+  for (unsigned int k = 0; k < n; k++) {
+    unsigned int v = order[k];
+    InstrInc(VERTEX_ITER);
+
+    if (distance[v] == unreachable) continue;
+
+    GraphAdjacents adj = GraphGetAdjacents(g, v);
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+      unsigned int w = adj.vertices[j];
+      InstrInc(EDGE_ITER);
+
+      double d = distance[v] + _weight(&adj, j);
+      if (longest ? (d > distance[w]) : (d < distance[w])) {
+        distance[w] = d;
+      }
+    }
+  }
+
+  return distance;
+}
+
+double* GraphDAGShortestDistances(const Graph* g, const GraphTopoSort* t, unsigned int source) {
+  return _distances(g, t, source, 0);
+}
+
+double* GraphDAGLongestDistances(const Graph* g, const GraphTopoSort* t, unsigned int source) {
+  return _distances(g, t, source, 1);
+}
@@ -0,0 +1,71 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Longest paths and critical path of a (weighted) DAG
+//
+// All computations take the topological order of a GraphTopoSort of the
+// same digraph, and go over each edge once (or twice, for the critical
+// path), reading the adjacents in place. Unweighted edges count as 1.
+//
+// For scheduling, an edge (v, w) with weight d means that w can only
+// start d time units after v has started.
+//
+
+#ifndef _GRAPH_CRITICAL_PATH_
+#define _GRAPH_CRITICAL_PATH_
+
+#include "Graph.h"
+#include "GraphTopologicalSorting.h"
+
+typedef struct _GraphCriticalPath GraphCriticalPath;
+
+//
+// Returns NULL if t holds no valid sorting
+//
+GraphCriticalPath* GraphCriticalPathCompute(const Graph* g,
+                                            const GraphTopoSort* t);
+
+void GraphCriticalPathDestroy(GraphCriticalPath** p);
+
+//
+// The earliest time at which every vertex can have started, if the vertices
+// without incoming edges start at time 0
+//
+double GraphCriticalPathGetLength(const GraphCriticalPath* p);
+
+double GraphCriticalPathGetEarliestStart(const GraphCriticalPath* p,
+                                         unsigned int v);
+
+//
+// The latest start of v that does not delay the whole schedule
+//
+double GraphCriticalPathGetLatestStart(const GraphCriticalPath* p,
+                                       unsigned int v);
+
+//
+// latest - earliest start: 0 (up to rounding) for the critical vertices
+//
+double GraphCriticalPathGetSlack(const GraphCriticalPath* p, unsigned int v);
+
+//
+// returns a longest path of the DAG, storing its number of vertices in *length
+// the array belongs to the GraphCriticalPath: DO NOT FREE IT
+//
+const unsigned int* GraphCriticalPathGetPath(const GraphCriticalPath* p,
+                                             unsigned int* length);
+
+void GraphCriticalPathDisplay(const GraphCriticalPath* p);
+
+//
+// Single-source distances along a DAG, in the order of t (which must be
+// valid): INFINITY (shortest) or -INFINITY (longest) for the vertices that
+// cannot be reached from source
+// MEMORY IS ALLOCATED FOR THE RESULTING ARRAY
+//
+double* GraphDAGShortestDistances(const Graph* g, const GraphTopoSort* t,
+                                  unsigned int source);
+
+double* GraphDAGLongestDistances(const Graph* g, const GraphTopoSort* t,
+                                 unsigned int source);
+
+#endif  // _GRAPH_CRITICAL_PATH_
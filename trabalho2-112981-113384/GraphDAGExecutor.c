@@ -0,0 +1,416 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Parallel execution of the vertices of a DAG (work stealing)
+//
+
+#include "GraphDAGExecutor.h"
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define EXECUTOR_POSIX 1
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include "Graph.h"
+#include "instrumentation.h"
+
+/* Número máximo de threads */
+#define MAX_THREADS 16
+
+/* Número de tentativas (cedendo o processador entre elas) de um trabalhador sem tarefas, antes de adormecer */
+#define SPIN_ROUNDS 32
+
+/* Definir as macros a serem usadas para a análise da complexidade */
+#define VERTEX_ITER 0
+#define EDGE_ITER 1
+#define STEALS 3
+#define IDLE_NS 4
+#define TASKS_PER_S 5
+
+#ifdef EXECUTOR_POSIX
+#define LOCK(d) pthread_mutex_lock(&(d)->lock)
+#define UNLOCK(d) pthread_mutex_unlock(&(d)->lock)
+#else
+#define LOCK(d) ((void)(d))
+#define UNLOCK(d) ((void)(d))
+#endif
+
+/*
+  Deque de tarefas prontas de um trabalhador: array circular (com capacidade potência de 2) das posições
+  [head, head + count). O dono acrescenta e retira no fim; os outros roubam no início
+*/
+struct _Deque {
+#ifdef EXECUTOR_POSIX
+  pthread_mutex_t lock;
+#endif
+  unsigned int* items;
+  size_t capacity;
+  size_t head;
+  size_t count;
+};
+
+/* Dados partilhados por todos os trabalhadores */
+struct _Execution {
+  const Graph* graph;
+  GraphDAGTask task;
+  void* arg;
+  _Atomic unsigned int* inDegree;  /* Predecessores de cada vértice ainda por terminar */
+  atomic_ulong pending;            /* Tarefas prontas ou a correr: quando chega a 0, não há mais nada a fazer */
+  unsigned int numWorkers;
+  struct _Deque* deques;
+#ifdef EXECUTOR_POSIX
+  /* Trabalhadores adormecidos, à espera de uma nova tarefa (ou do fim) */
+  pthread_mutex_t idleLock;
+  pthread_cond_t wakeUp;
+  atomic_uint numSleeping;
+  atomic_ulong numSignals;         /* Incrementado sempre que há uma nova tarefa pronta, ou no fim */
+#endif
+};
+
+/* Dados de cada trabalhador */
+struct _Worker {
+  struct _Execution* execution;
+  unsigned int id;
+  unsigned long numTasks;      /* Contadores locais, somados no fim (não são atómicos) */
+  unsigned long numEdges;
+  unsigned long numSteals;
+  double idleTime;
+};
+
+/* Tempo real, em segundos */
+static double _wallTime(void) {
+  struct timespec now;
+  if (clock_gettime(CLOCK_MONOTONIC, &now) != 0) return 0.0;
+  return (double)now.tv_sec + 1.0e-9 * (double)now.tv_nsec;
+}
+
+// AUXILIARY FUNCTIONS for the DEQUES
+
+static void _dequeInit(struct _Deque* d) {
+#ifdef EXECUTOR_POSIX
+  pthread_mutex_init(&d->lock, NULL);
+#endif
+  d->capacity = 64;
+  d->items = (unsigned int*)malloc(d->capacity * sizeof(unsigned int));
+  if (d->items == NULL) abort();
+  d->head = 0;
+  d->count = 0;
+}
+
+static void _dequeDestroy(struct _Deque* d) {
+#ifdef EXECUTOR_POSIX
+  pthread_mutex_destroy(&d->lock);
+#endif
+  free(d->items);
+}
+
+/* Acrescentar no fim, duplicando a capacidade se estiver cheio */
+static void _dequePush(struct _Deque* d, unsigned int v) {
+  LOCK(d);
+  if (d->count == d->capacity) {
+    unsigned int* items = (unsigned int*)malloc(2 * d->capacity * sizeof(unsigned int));
+    if (items == NULL) abort();
+    for (size_t k = 0; k < d->count; k++) {
+      items[k] = d->items[(d->head + k) & (d->capacity - 1)];
+    }
+    free(d->items);
+    d->items = items;
+    d->capacity *= 2;
+    d->head = 0;
+  }
+  d->items[(d->head + d->count) & (d->capacity - 1)] = v;
+  d->count++;
+  UNLOCK(d);
+}
+
+/* Retirar do fim (a tarefa mais recente, cujos dados ainda devem estar na cache): devolve 0 se estiver vazio */
+static int _dequePop(struct _Deque* d, unsigned int* v) {
+  int found = 0;
+  LOCK(d);
+  if (d->count > 0) {
+    d->count--;
+    *v = d->items[(d->head + d->count) & (d->capacity - 1)];
+    found = 1;
+  }
+  UNLOCK(d);
+  return found;
+}
+
+/* Roubar do início (a tarefa mais antiga): devolve 0 se estiver vazio */
+static int _dequeSteal(struct _Deque* d, unsigned int* v) {
+  int found = 0;
+  LOCK(d);
+  if (d->count > 0) {
+    *v = d->items[d->head];
+    d->head = (d->head + 1) & (d->capacity - 1);
+    d->count--;
+    found = 1;
+  }
+  UNLOCK(d);
+  return found;
+}
+
+
+// AUXILIARY FUNCTIONS for the IDLE WORKERS
+
+#ifdef EXECUTOR_POSIX
+/*
+  Avisar os trabalhadores adormecidos de que há uma nova tarefa (acordando um) ou de que não há mais nada a fazer
+  (acordando todos); se nenhum estiver adormecido, nem é preciso usar o mutex
+*/
+static void _signalWorkers(struct _Execution* e, int all) {
+  atomic_fetch_add(&e->numSignals, 1);
+  if (atomic_load(&e->numSleeping) > 0) {
+    pthread_mutex_lock(&e->idleLock);
+    if (all) {
+      pthread_cond_broadcast(&e->wakeUp);
+    } else {
+      pthread_cond_signal(&e->wakeUp);
+    }
+    pthread_mutex_unlock(&e->idleLock);
+  }
+}
+
+/*
+  Adormecer até haver algum aviso depois de 'seen' (o valor de numSignals antes de procurar tarefas)
+  numSleeping é incrementado antes de numSignals ser relido, e _signalWorkers faz o inverso: um dos dois vê sempre
+  a alteração do outro, e nenhum aviso se perde
+*/
+static void _sleep(struct _Execution* e, unsigned long seen) {
+  pthread_mutex_lock(&e->idleLock);
+  atomic_fetch_add(&e->numSleeping, 1);
+  while (atomic_load(&e->numSignals) == seen && atomic_load(&e->pending) != 0) {
+    pthread_cond_wait(&e->wakeUp, &e->idleLock);
+  }
+  atomic_fetch_sub(&e->numSleeping, 1);
+  pthread_mutex_unlock(&e->idleLock);
+}
+#endif
+
+
+/* Ciclo de cada trabalhador: correr tarefas (suas ou roubadas) até não haver nenhuma pronta nem a correr */
+static void* _work(void* arg) {
+  struct _Worker* worker = (struct _Worker*)arg;
+  struct _Execution* e = worker->execution;
+  struct _Deque* own = &e->deques[worker->id];
+
+  double idleSince = -1.0;
+  unsigned int idleRounds = 0;
+
+  for (;;) {
+#ifdef EXECUTOR_POSIX
+    unsigned long seen = atomic_load(&e->numSignals);
+#endif
+    unsigned int v;
+    int found = _dequePop(own, &v);
+
+    /* Sem tarefas próprias: tentar roubar uma aos outros, começando pelo seguinte */
+    for (unsigned int k = 1; !found && k < e->numWorkers; k++) {
+      if (_dequeSteal(&e->deques[(worker->id + k) % e->numWorkers], &v)) {
+        found = 1;
+        worker->numSteals++;
+      }
+    }
+
+    if (!found) {
+      if (idleSince < 0.0) idleSince = _wallTime();
+      if (atomic_load(&e->pending) == 0) break;
+#ifdef EXECUTOR_POSIX
+      /* Primeiro, umas poucas tentativas seguidas (as tarefas podem estar quase a ficar prontas); depois, dormir */
+      if (++idleRounds < SPIN_ROUNDS) {
+        sched_yield();
+      } else {
+        _sleep(e, seen);
+      }
+#endif
+      continue;
+    }
+
+    idleRounds = 0;
+    if (idleSince >= 0.0) {
+      worker->idleTime += _wallTime() - idleSince;
+      idleSince = -1.0;
+    }
+
+    e->task(v, e->arg);
+    worker->numTasks++;
+
+    /* Os sucessores cujo último predecessor era 'v' ficam prontos (antes de 'v' deixar de estar pendente) */
+    GraphAdjacents adj = GraphGetAdjacents(e->graph, v);
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+      unsigned int w = adj.vertices[j];
+      worker->numEdges++;
+
+      if (atomic_fetch_sub_explicit(&e->inDegree[w], 1, memory_order_acq_rel) == 1) {
+        atomic_fetch_add(&e->pending, 1);
+        _dequePush(own, w);
+#ifdef EXECUTOR_POSIX
+        _signalWorkers(e, 0);
+#endif
+      }
+    }
+
+    /* Se era a última tarefa, os trabalhadores adormecidos têm de acordar para terminar */
+    if (atomic_fetch_sub(&e->pending, 1) == 1) {
+#ifdef EXECUTOR_POSIX
+      _signalWorkers(e, 1);
+#endif
+    }
+  }
+
+  if (idleSince >= 0.0) {
+    worker->idleTime += _wallTime() - idleSince;
+  }
+  return NULL;
+}
+
+/* Número de threads a usar, se não for indicado */
+static unsigned int _numThreads(void) {
+  long cpus = 1;
+#ifdef EXECUTOR_POSIX
+  cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (cpus < 1) cpus = 1;
+  if (cpus > MAX_THREADS) cpus = MAX_THREADS;
+  return (unsigned int)cpus;
+}
+
+
+int GraphDAGExecute(const Graph* g, GraphDAGTask task, void* arg, unsigned int numThreads,
+                    GraphDAGExecutorStats* stats) {
+  assert(g != NULL && GraphIsDigraph(g) == 1);
+  assert(task != NULL);
+
+  if (numThreads == 0) numThreads = _numThreads();
+  if (numThreads > MAX_THREADS) numThreads = MAX_THREADS;
+#ifndef EXECUTOR_POSIX
+  numThreads = 1;
+#endif
+
+  unsigned int n = GraphGetNumVertices(g);
+
+  struct _Execution e;
+  e.graph = g;
+  e.task = task;
+  e.arg = arg;
+  e.numWorkers = numThreads;
+  e.inDegree = (_Atomic unsigned int*)malloc((n + 1) * sizeof(_Atomic unsigned int));
+  e.deques = (struct _Deque*)malloc(numThreads * sizeof(struct _Deque));
+  if (e.inDegree == NULL || e.deques == NULL) abort();
+
+  for (unsigned int t = 0; t < numThreads; t++) {
+    _dequeInit(&e.deques[t]);
+  }
+#ifdef EXECUTOR_POSIX
+  pthread_mutex_init(&e.idleLock, NULL);
+  pthread_cond_init(&e.wakeUp, NULL);
+  atomic_init(&e.numSleeping, 0);
+  atomic_init(&e.numSignals, 0);
+#endif
+
+  /* Os vértices sem arestas incidentes ficam prontos desde o início, repartidos pelos trabalhadores */
+  unsigned long ready = 0;
+  for (unsigned int v = 0; v < n; v++) {
+    unsigned int inDegree = GraphGetVertexInDegree(g, v);
+    atomic_init(&e.inDegree[v], inDegree);
+    if (inDegree == 0) {
+      _dequePush(&e.deques[ready % numThreads], v);
+      ready++;
+    }
+  }
+  atomic_init(&e.pending, ready);
+
+  struct _Worker workers[MAX_THREADS];
+  for (unsigned int t = 0; t < numThreads; t++) {
+    workers[t].execution = &e;
+    workers[t].id = t;
+    workers[t].numTasks = 0;
+    workers[t].numEdges = 0;
+    workers[t].numSteals = 0;
+    workers[t].idleTime = 0.0;
+  }
+
+  double start = _wallTime();
+
+  /* Número de threads efetivamente criadas, incluindo esta */
+  unsigned int numStarted = 1;
+
+#ifdef EXECUTOR_POSIX
+  /* O trabalhador 0 é esta thread; se alguma não puder ser criada, as outras roubam o seu trabalho */
+  pthread_t threads[MAX_THREADS];
+  unsigned int started = 0;
+  for (unsigned int t = 1; t < numThreads; t++) {
+    if (pthread_create(&threads[t], NULL, _work, &workers[t]) != 0) {
+      break;
+    }
+    started = t;
+  }
+  numStarted = started + 1;
+  _work(&workers[0]);
+  for (unsigned int t = 1; t <= started; t++) {
+    pthread_join(threads[t], NULL);
+  }
+#else
+  _work(&workers[0]);
+#endif
+
+  double wallTime = _wallTime() - start;
+
+  unsigned long numTasks = 0;
+  unsigned long numEdges = 0;
+  unsigned long numSteals = 0;
+  double idleTime = 0.0;
+  for (unsigned int t = 0; t < numThreads; t++) {
+    numTasks += workers[t].numTasks;
+    numEdges += workers[t].numEdges;
+    numSteals += workers[t].numSteals;
+    idleTime += workers[t].idleTime;
+  }
+
+  InstrAdd(VERTEX_ITER, numTasks);
+  InstrAdd(EDGE_ITER, numEdges);
+
+  double throughput = (wallTime > 0.0) ? (double)numTasks / wallTime : 0.0;
+  InstrAdd(STEALS, numSteals);
+  InstrAdd(IDLE_NS, idleTime * 1e9 + 0.5);
+  InstrAdd(TASKS_PER_S, throughput + 0.5);
+
+  if (stats != NULL) {
+    stats->numThreads = numStarted;
+    stats->numTasks = numTasks;
+    stats->numSteals = numSteals;
+    stats->wallTime = wallTime;
+    stats->idleTime = idleTime;
+    stats->throughput = throughput;
+  }
+
+  for (unsigned int t = 0; t < numThreads; t++) {
+    _dequeDestroy(&e.deques[t]);
+  }
+#ifdef EXECUTOR_POSIX
+  pthread_cond_destroy(&e.wakeUp);
+  pthread_mutex_destroy(&e.idleLock);
+#endif
+  free(e.deques);
+  free(e.inDegree);
+
+  return numTasks == n;
+}
+
+
+void GraphDAGExecutorStatsDisplay(const GraphDAGExecutorStats* stats) {
+  assert(stats != NULL);
+
+  printf("Threads = %u | Tasks = %lu | Steals = %lu\n", stats->numThreads, stats->numTasks,
+         stats->numSteals);
+  printf("Wall time = %.6f s | Idle time = %.6f s | Throughput = %.0f tasks/s\n", stats->wallTime,
+         stats->idleTime, stats->throughput);
+}
@@ -0,0 +1,55 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Parallel execution of the vertices of a DAG
+//
+// Every vertex is a task, and an edge (v, w) means that w can only run after
+// v has finished. Tasks run on a pool of worker threads as soon as their
+// last predecessor finishes: each worker keeps its ready tasks in its own
+// deque, running the newest one first, and steals the oldest task of
+// another worker when its deque is empty. A worker that finds no task for a
+// while sleeps until a new one becomes ready.
+//
+// Counters added to the instrumentation module (see instrumentation.h):
+//   InstrCount[0] - tasks run
+//   InstrCount[1] - edges visited
+//   InstrCount[3] - tasks taken from another worker's deque
+//   InstrCount[4] - idle time of the workers, in nanoseconds
+//   InstrCount[5] - throughput, in tasks per second
+// These are also given, with the wall time, in GraphDAGExecutorStats.
+//
+
+#ifndef _GRAPH_DAG_EXECUTOR_
+#define _GRAPH_DAG_EXECUTOR_
+
+#include "Graph.h"
+
+//
+// The task of vertex v, called with the arg given to GraphDAGExecute
+// Several tasks run at the same time, in different threads
+//
+typedef void (*GraphDAGTask)(unsigned int v, void* arg);
+
+typedef struct _GraphDAGExecutorStats {
+  unsigned int numThreads;  // Worker threads actually started (including
+                            // the calling thread)
+  unsigned long numTasks;   // Tasks run
+  unsigned long numSteals;  // Tasks taken from another worker's deque
+  double wallTime;          // Seconds, from start to finish
+  double idleTime;          // Seconds spent by the workers without a task,
+                            // mostly asleep (summed over all workers)
+  double throughput;        // Tasks per second
+} GraphDAGExecutorStats;
+
+//
+// Runs the tasks of all vertices of g (a digraph) on numThreads workers
+// (0 for one per core), filling *stats if it is not NULL
+// Returns 1 if every task ran, and 0 if g has a cycle: the vertices on a
+// cycle, or reachable from one, never become ready
+//
+int GraphDAGExecute(const Graph* g, GraphDAGTask task, void* arg,
+                    unsigned int numThreads, GraphDAGExecutorStats* stats);
+
+void GraphDAGExecutorStatsDisplay(const GraphDAGExecutorStats* stats);
+
+#endif  // _GRAPH_DAG_EXECUTOR_
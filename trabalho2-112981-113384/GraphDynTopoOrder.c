@@ -0,0 +1,327 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Dynamic topological order of a digraph (Pearce-Kelly)
+//
+
+#include "GraphDynTopoOrder.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Graph.h"
+#include "GraphTopologicalSorting.h"
+#include "instrumentation.h"
+
+struct _GraphDynTopoOrder {
+  Graph* graph;                 /* Grafo a que a ordem pertence */
+  unsigned int numVertices;
+  unsigned int* position;       /* Posição de cada vértice na ordem */
+  unsigned int* vertexAt;       /* Vértice em cada posição (a ordem) */
+  int enabledIncoming;          /* Foi a ordem a ativar as arestas que chegam a cada vértice, no grafo? */
+  char* visited;                /* Vértices já visitados pela pesquisa atual (tudo a 0 entre pesquisas) */
+  unsigned int* stack;          /* Pilha da pesquisa em profundidade */
+  unsigned int* forward;        /* Vértices alcançáveis a partir de w (na inserção de (v, w)) */
+  unsigned int* backward;       /* Vértices que alcançam v */
+  unsigned int* positions;      /* Posições a redistribuir pelos vértices de 'forward' e 'backward' */
+};
+
+/* Definir as macros a serem usadas para a análise da complexidade */
+#define VERTEX_ITER 0
+#define EDGE_ITER 1
+
+GraphDynTopoOrder* GraphDynTopoOrderCreate(Graph* g) {
+  assert(g != NULL && GraphIsDigraph(g) == 1);
+
+  /* A ordem inicial é calculada de uma só vez, com o 3º algoritmo */
+  GraphTopoSort* topoSort = GraphTopoSortComputeV3(g);
+  if (topoSort == NULL) return NULL;
+
+  unsigned int* sequence = GraphTopoSortGetSequence(topoSort);
+  if (sequence == NULL) {
+    /* O grafo tem ciclos */
+    GraphTopoSortDestroy(&topoSort);
+    return NULL;
+  }
+
+  GraphDynTopoOrder* p = (GraphDynTopoOrder*)malloc(sizeof(struct _GraphDynTopoOrder));
+  if (p == NULL) abort();
+
+  unsigned int n = GraphGetNumVertices(g);
+  p->graph = g;
+  p->numVertices = n;
+
+  /* "+ 1" para nunca pedir 0 bytes */
+  p->position = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  p->vertexAt = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  p->visited = (char*)calloc(n + 1, sizeof(char));
+  p->stack = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  p->forward = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  p->backward = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  p->positions = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  if (p->position == NULL || p->vertexAt == NULL || p->visited == NULL ||
+      p->stack == NULL || p->forward == NULL || p->backward == NULL || p->positions == NULL) {
+    abort();
+  }
+
+  for (unsigned int i = 0; i < n; i++) {
+    p->vertexAt[i] = sequence[i];
+    p->position[sequence[i]] = i;
+  }
+  GraphTopoSortDestroy(&topoSort);
+
+  /*
+    A pesquisa para trás usa as arestas que chegam a cada vértice, guardadas e mantidas pelo próprio grafo
+    (são ativadas aqui, se ainda não estiverem, e desativadas quando a ordem for destruída)
+  */
+  p->enabledIncoming = !GraphHasIncomingEdges(g);
+  if (p->enabledIncoming) {
+    GraphEnableIncomingEdges(g);
+  }
+
+  return p;
+}
+
+
+void GraphDynTopoOrderDestroy(GraphDynTopoOrder** p) {
+  assert(*p != NULL);
+
+  GraphDynTopoOrder* aux = *p;
+
+  if (aux->enabledIncoming) {
+    GraphDisableIncomingEdges(aux->graph);
+  }
+  free(aux->position);
+  free(aux->vertexAt);
+  free(aux->visited);
+  free(aux->stack);
+  free(aux->forward);
+  free(aux->backward);
+  free(aux->positions);
+
+  free(*p);
+  *p = NULL;
+}
+
+
+/* Ordenação crescente de posições */
+static int _comparePositions(const void* a, const void* b) {
+  unsigned int x = *(const unsigned int*)a;
+  unsigned int y = *(const unsigned int*)b;
+  return (x > y) - (x < y);
+}
+
+/*
+  Substituir os 'count' vértices de 'vertices' pelas suas posições, por ordem crescente
+  (os vértices correspondentes voltam a ser obtidos com vertexAt, que ainda não foi alterado)
+*/
+static void _sortByPosition(const GraphDynTopoOrder* p, unsigned int* vertices, unsigned int count) {
+  for (unsigned int i = 0; i < count; i++) {
+    vertices[i] = p->position[vertices[i]];
+  }
+  qsort(vertices, count, sizeof(unsigned int), _comparePositions);
+}
+
+/*
+  Preparar a inserção da aresta (v, w), com 'w' antes de 'v' na ordem (Pearce-Kelly):
+    1 - pesquisa em profundidade, para a frente, a partir de 'w', apenas pelos vértices com posição menor que a de 'v':
+        se 'v' for alcançado, a aresta fecha um ciclo;
+    2 - pesquisa em profundidade, para trás, a partir de 'v', apenas pelos vértices com posição maior que a de 'w';
+    3 - os vértices encontrados ficam com as posições que já ocupavam: primeiro os da pesquisa 2, depois os da 1,
+        cada grupo mantendo a sua ordem relativa.
+  Devolve 0 se a aresta fechar um ciclo (e nesse caso a ordem não é alterada), e 1 caso contrário
+*/
+static int _reorder(GraphDynTopoOrder* p, unsigned int v, unsigned int w) {
+  unsigned int lowerBound = p->position[w];
+  unsigned int upperBound = p->position[v];
+
+  /* 1 - Para a frente, a partir de 'w' */
+  unsigned int numForward = 0;
+  unsigned int top = 0;
+  p->visited[w] = 1;
+  p->forward[numForward++] = w;
+  p->stack[top++] = w;
+
+  int cycle = 0;
+  while (top > 0 && !cycle) {
+    unsigned int u = p->stack[--top];
+    InstrInc(VERTEX_ITER);
+
+    GraphAdjacents adj = GraphGetAdjacents(p->graph, u);
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+      unsigned int z = adj.vertices[j];
+      InstrInc(EDGE_ITER);
+
+      if (z == v) {
+        cycle = 1;
+        break;
+      }
+      if (!p->visited[z] && p->position[z] < upperBound) {
+        p->visited[z] = 1;
+        p->forward[numForward++] = z;
+        p->stack[top++] = z;
+      }
+    }
+  }
+
+  if (cycle) {
+    for (unsigned int i = 0; i < numForward; i++) {
+      p->visited[p->forward[i]] = 0;
+    }
+    return 0;
+  }
+
+  /* 2 - Para trás, a partir de 'v' (não encontra nenhum vértice da pesquisa 1, senão havia um ciclo) */
+  unsigned int numBackward = 0;
+  p->visited[v] = 1;
+  p->backward[numBackward++] = v;
+  p->stack[top++] = v;
+
+  while (top > 0) {
+    unsigned int u = p->stack[--top];
+    InstrInc(VERTEX_ITER);
+
+    GraphAdjacents in = GraphGetIncoming(p->graph, u);
+    for (unsigned int j = 0; j < in.numAdjacents; j++) {
+      unsigned int z = in.vertices[j];
+      InstrInc(EDGE_ITER);
+
+      if (!p->visited[z] && p->position[z] > lowerBound) {
+        p->visited[z] = 1;
+        p->backward[numBackward++] = z;
+        p->stack[top++] = z;
+      }
+    }
+  }
+
+  /* 3 - Redistribuir as posições */
+  _sortByPosition(p, p->forward, numForward);
+  _sortByPosition(p, p->backward, numBackward);
+
+  /* Juntar as posições dos dois grupos (já ordenadas), e voltar a obter os vértices de cada grupo (pela mesma ordem) */
+  unsigned int i = 0;
+  unsigned int j = 0;
+  unsigned int k = 0;
+  while (i < numBackward || j < numForward) {
+    if (j == numForward || (i < numBackward && p->backward[i] < p->forward[j])) {
+      p->positions[k++] = p->backward[i];
+      p->backward[i] = p->vertexAt[p->backward[i]];
+      i++;
+    } else {
+      p->positions[k++] = p->forward[j];
+      p->forward[j] = p->vertexAt[p->forward[j]];
+      j++;
+    }
+  }
+
+  k = 0;
+  for (i = 0; i < numBackward; i++, k++) {
+    unsigned int u = p->backward[i];
+    p->visited[u] = 0;
+    p->position[u] = p->positions[k];
+    p->vertexAt[p->positions[k]] = u;
+  }
+  for (j = 0; j < numForward; j++, k++) {
+    unsigned int u = p->forward[j];
+    p->visited[u] = 0;
+    p->position[u] = p->positions[k];
+    p->vertexAt[p->positions[k]] = u;
+  }
+
+  return 1;
+}
+
+
+static int _addEdge(GraphDynTopoOrder* p, unsigned int v, unsigned int w, double weight) {
+  assert(v < p->numVertices);
+  assert(w < p->numVertices);
+
+  if (v == w) {
+    return -1;  // A self-loop is a cycle
+  }
+
+  /* Se 'v' já está antes de 'w', a ordem não muda; se a aresta já existir, é esse o caso */
+  if (p->position[v] > p->position[w] && _reorder(p, v, w) == 0) {
+    return -1;
+  }
+
+  /* O grafo atualiza também as arestas que chegam a 'w' */
+  return GraphIsWeighted(p->graph) ? GraphAddWeightedEdge(p->graph, v, w, weight)
+                                   : GraphAddEdge(p->graph, v, w);
+}
+
+int GraphDynTopoOrderAddEdge(GraphDynTopoOrder* p, unsigned int v, unsigned int w) {
+  assert(p != NULL && GraphIsWeighted(p->graph) == 0);
+  return _addEdge(p, v, w, 1.0);
+}
+
+int GraphDynTopoOrderAddWeightedEdge(GraphDynTopoOrder* p, unsigned int v, unsigned int w,
+                                     double weight) {
+  assert(p != NULL && GraphIsWeighted(p->graph) == 1);
+  return _addEdge(p, v, w, weight);
+}
+
+
+int GraphDynTopoOrderRemoveEdge(GraphDynTopoOrder* p, unsigned int v, unsigned int w) {
+  assert(p != NULL);
+
+  /* A ordem continua válida: basta remover a aresta do grafo (e das que chegam a 'w') */
+  return GraphRemoveEdge(p->graph, v, w);
+}
+
+
+unsigned int GraphDynTopoOrderGetPosition(const GraphDynTopoOrder* p, unsigned int v) {
+  assert(p != NULL && v < p->numVertices);
+  return p->position[v];
+}
+
+const unsigned int* GraphDynTopoOrderGetSequence(const GraphDynTopoOrder* p) {
+  assert(p != NULL);
+  return p->vertexAt;
+}
+
+
+// CHECKING
+
+int GraphDynTopoOrderCheckInvariants(const GraphDynTopoOrder* p) {
+  assert(p != NULL);
+
+  if (GraphGetNumVertices(p->graph) != p->numVertices || !GraphHasIncomingEdges(p->graph)) {
+    return 0;
+  }
+
+  for (unsigned int v = 0; v < p->numVertices; v++) {
+    /* 'position' e 'vertexAt' são inversas uma da outra */
+    if (p->position[v] >= p->numVertices || p->vertexAt[p->position[v]] != v) {
+      return 0;
+    }
+
+    /* Todas as arestas vão de uma posição para uma posição posterior */
+    GraphAdjacents adj = GraphGetAdjacents(p->graph, v);
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+      if (p->position[v] >= p->position[adj.vertices[j]]) {
+        return 0;
+      }
+    }
+
+    if (p->visited[v] != 0) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+
+// DISPLAYING on the console
+
+void GraphDynTopoOrderDisplaySequence(const GraphDynTopoOrder* p) {
+  assert(p != NULL);
+
+  printf("Topological Order - Vertex indices:\n");
+  for (unsigned int i = 0; i < p->numVertices; i++) {
+    printf("%d ", p->vertexAt[i]);
+  }
+  printf("\n");
+}
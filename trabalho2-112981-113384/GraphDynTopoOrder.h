@@ -0,0 +1,78 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Dynamic topological order of a digraph
+//
+// Keeps a topological order of a DAG while edges are added and removed,
+// using the Pearce-Kelly algorithm: inserting an edge (v, w) with v already
+// before w costs no more than GraphAddEdge; otherwise only the vertices whose
+// positions lie between those of w and v, and that are reachable from w or
+// reach v, are visited and reordered. Insertions that would close a cycle are
+// rejected.
+//
+// The order is tied to the Graph given at creation: while it exists, the
+// edges of that graph must only be changed through the functions below.
+// The backward searches use the graph's incoming edges: they are enabled at
+// creation, if needed, and then disabled again by GraphDynTopoOrderDestroy.
+//
+
+#ifndef _GRAPH_DYN_TOPO_ORDER_
+#define _GRAPH_DYN_TOPO_ORDER_
+
+#include "Graph.h"
+
+typedef struct _GraphDynTopoOrder GraphDynTopoOrder;
+
+//
+// Computes the initial order of g (a digraph)
+// Returns NULL if g is not acyclic
+//
+GraphDynTopoOrder* GraphDynTopoOrderCreate(Graph* g);
+
+void GraphDynTopoOrderDestroy(GraphDynTopoOrder** p);
+
+// Edges
+//
+// The add functions return 1 if the edge was added, 0 if it already
+// existed and -1 if it was rejected because it would close a cycle (which
+// includes v == w); the graph and the order are not changed in the last two
+// cases
+//
+
+int GraphDynTopoOrderAddEdge(GraphDynTopoOrder* p, unsigned int v,
+                             unsigned int w);
+
+int GraphDynTopoOrderAddWeightedEdge(GraphDynTopoOrder* p, unsigned int v,
+                                     unsigned int w, double weight);
+
+//
+// returns 1 if the edge was removed, 0 if it did not exist
+// The current order remains valid, so it is not changed
+//
+int GraphDynTopoOrderRemoveEdge(GraphDynTopoOrder* p, unsigned int v,
+                                unsigned int w);
+
+// Getting the order
+
+//
+// The position of vertex v in the order
+//
+unsigned int GraphDynTopoOrderGetPosition(const GraphDynTopoOrder* p,
+                                          unsigned int v);
+
+//
+// The vertices, in topological order
+// the array belongs to the GraphDynTopoOrder, and changes with every edge
+// insertion: DO NOT FREE IT
+//
+const unsigned int* GraphDynTopoOrderGetSequence(const GraphDynTopoOrder* p);
+
+// CHECKING
+
+int GraphDynTopoOrderCheckInvariants(const GraphDynTopoOrder* p);
+
+// DISPLAYING on the console
+
+void GraphDynTopoOrderDisplaySequence(const GraphDynTopoOrder* p);
+
+#endif  // _GRAPH_DYN_TOPO_ORDER_
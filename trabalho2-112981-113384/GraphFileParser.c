@@ -0,0 +1,522 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Graph file parser
+//
+
+#include "GraphFileParser.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define PARSER_POSIX 1
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* Número máximo de threads, e tamanho mínimo (em bytes) do pedaço de texto de cada uma */
+#define MAX_THREADS 16
+#define MIN_CHUNK_SIZE (1 << 16)
+
+/* Tipos de erro numa linha de aresta */
+#define ERROR_NONE 0
+#define ERROR_EDGE 1
+#define ERROR_WEIGHT 2
+#define ERROR_VERTEX 3
+#define ERROR_EXTRA 4
+
+/* Texto de um ficheiro, mapeado em memória (ou lido para um buffer) */
+struct _FileText {
+  const char* begin;        /* Primeiro carácter a processar */
+  const char* end;          /* Depois do último */
+  void* mapping;            /* Início do mapeamento (NULL se foi lido para um buffer) */
+  size_t mappingSize;
+  char* buffer;             /* Buffer com o texto (NULL se foi mapeado) */
+};
+
+/* Pedaço de linhas inteiras do ficheiro, processado por uma thread */
+struct _Chunk {
+  const char* begin;
+  const char* end;
+  const GraphFileData* data;  /* Onde escrever as arestas */
+  unsigned int firstEdge;     /* Índice (no ficheiro) da primeira aresta do pedaço */
+  unsigned int numLines;      /* Número de linhas de arestas (não vazias) do pedaço */
+  unsigned int numKept;       /* Número de arestas guardadas (sem lacetes) */
+  unsigned int errorEdge;     /* Índice da primeira aresta com erro */
+  int error;                  /* Tipo desse erro */
+};
+
+// AUXILIARY FUNCTIONS for PARSING numbers
+
+static int _isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/* Avançar os espaços (sem mudar de linha) */
+static const char* _skipSpaces(const char* p, const char* end) {
+  while (p < end && _isSpace(*p)) p++;
+  return p;
+}
+
+/* Avançar os espaços e as mudanças de linha */
+static const char* _skipWhite(const char* p, const char* end) {
+  while (p < end && (_isSpace(*p) || *p == '\n')) p++;
+  return p;
+}
+
+/* Ler um inteiro sem sinal: devolve a posição a seguir, ou NULL se não houver um número válido */
+static const char* _parseUnsigned(const char* p, const char* end, unsigned int* value) {
+  if (p == end || *p < '0' || *p > '9') return NULL;
+
+  unsigned long long v = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    v = 10 * v + (unsigned int)(*p - '0');
+    if (v > UINT_MAX) return NULL;
+    p++;
+  }
+
+  *value = (unsigned int)v;
+  return p;
+}
+
+/* Ler um inteiro, possivelmente com sinal */
+static const char* _parseInt(const char* p, const char* end, int* value) {
+  int negative = 0;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    p++;
+  }
+
+  unsigned int v;
+  p = _parseUnsigned(p, end, &v);
+  if (p == NULL || v > INT_MAX) return NULL;
+
+  *value = negative ? -(int)v : (int)v;
+  return p;
+}
+
+/*
+  Ler um número real
+  Caso mais comum (até 15 algarismos significativos, sem expoente): a mantissa inteira e a potência
+  de 10 são ambas exatas em double, e uma única divisão dá o valor corretamente arredondado, tal como strtod
+  Nos restantes casos, o número é copiado para um buffer terminado em '\0' e lido com strtod
+*/
+static const char* _parseDouble(const char* p, const char* end, double* value) {
+  static const double powersOf10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                      1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                      1e12, 1e13, 1e14, 1e15};
+  const char* start = p;
+
+  int negative = 0;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    p++;
+  }
+
+  uint64_t mantissa = 0;
+  int numDigits = 0;
+  int fractionDigits = 0;
+  int significant = 0;
+
+  while (p < end && *p >= '0' && *p <= '9') {
+    mantissa = 10 * mantissa + (uint64_t)(*p - '0');
+    if (mantissa != 0) significant++;
+    numDigits++;
+    p++;
+  }
+  if (p < end && *p == '.') {
+    p++;
+    while (p < end && *p >= '0' && *p <= '9') {
+      mantissa = 10 * mantissa + (uint64_t)(*p - '0');
+      if (mantissa != 0) significant++;
+      numDigits++;
+      fractionDigits++;
+      p++;
+    }
+  }
+
+  int simple = (numDigits > 0 && significant <= 15 && fractionDigits <= 15 &&
+                (p == end || (*p != 'e' && *p != 'E' && *p != 'n' && *p != 'N' &&
+                              *p != 'i' && *p != 'I' && *p != 'x' && *p != 'X')));
+  if (simple) {
+    double v = (double)mantissa / powersOf10[fractionDigits];
+    *value = negative ? -v : v;
+    return p;
+  }
+
+  /* Caso geral */
+  char token[64];
+  size_t length = 0;
+  p = start;
+  while (p < end && !_isSpace(*p) && *p != '\n' && length < sizeof(token) - 1) {
+    token[length++] = *p++;
+  }
+  token[length] = '\0';
+
+  char* tokenEnd;
+  *value = strtod(token, &tokenEnd);
+  if (tokenEnd == token) return NULL;
+
+  return start + (tokenEnd - token);
+}
+
+// AUXILIARY FUNCTIONS for the FILE TEXT
+
+/* Obter o texto do ficheiro, a partir da posição atual: mapeado em memória, se possível, ou lido para um buffer */
+static int _openText(FILE* f, struct _FileText* text) {
+  text->mapping = NULL;
+  text->mappingSize = 0;
+  text->buffer = NULL;
+
+#ifdef PARSER_POSIX
+  struct stat st;
+  long position = ftell(f);
+
+  if (position >= 0 && fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode) &&
+      st.st_size > 0 && (off_t)position <= st.st_size) {
+    void* mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+    if (mapping != MAP_FAILED) {
+      /* O texto vai ser lido sequencialmente, uma única vez */
+      madvise(mapping, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+      text->mapping = mapping;
+      text->mappingSize = (size_t)st.st_size;
+      text->begin = (const char*)mapping + position;
+      text->end = (const char*)mapping + st.st_size;
+
+      /* O ficheiro fica "lido até ao fim", como se tivesse sido lido com fscanf */
+      fseek(f, 0, SEEK_END);
+      return 1;
+    }
+  }
+#endif
+
+  /* Alternativa (pipes, ficheiros vazios, outros sistemas): ler tudo para um buffer */
+  size_t capacity = 1 << 16;
+  size_t size = 0;
+  char* buffer = (char*)malloc(capacity);
+  if (buffer == NULL) abort();
+
+  size_t n;
+  while ((n = fread(buffer + size, 1, capacity - size, f)) > 0) {
+    size += n;
+    if (size == capacity) {
+      capacity *= 2;
+      buffer = (char*)realloc(buffer, capacity);
+      if (buffer == NULL) abort();
+    }
+  }
+
+  text->buffer = buffer;
+  text->begin = buffer;
+  text->end = buffer + size;
+  return 1;
+}
+
+static void _closeText(struct _FileText* text) {
+#ifdef PARSER_POSIX
+  if (text->mapping != NULL) {
+    munmap(text->mapping, text->mappingSize);
+  }
+#endif
+  free(text->buffer);
+}
+
+// AUXILIARY FUNCTIONS for the EDGE LINES (run by each thread)
+
+/* 1ª passagem: contar as linhas não vazias do pedaço */
+static void* _countLines(void* arg) {
+  struct _Chunk* c = (struct _Chunk*)arg;
+
+  unsigned int numLines = 0;
+  const char* p = c->begin;
+  while (p < c->end) {
+    p = _skipWhite(p, c->end);
+    if (p == c->end) break;
+
+    numLines++;
+    const char* eol = memchr(p, '\n', (size_t)(c->end - p));
+    p = (eol == NULL) ? c->end : eol + 1;
+  }
+
+  c->numLines = numLines;
+  return NULL;
+}
+
+/* 2ª passagem: ler as arestas do pedaço, guardando-as (sem os lacetes) a partir da posição firstEdge */
+static void* _parseLines(void* arg) {
+  struct _Chunk* c = (struct _Chunk*)arg;
+  const GraphFileData* data = c->data;
+
+  /* As linhas a mais no ficheiro (depois de numEdges arestas) não são lidas: são reportadas por GraphFileParse */
+  unsigned int numLines = c->numLines;
+  if (c->firstEdge >= data->numEdges) {
+    numLines = 0;
+  } else if (c->firstEdge + numLines > data->numEdges) {
+    numLines = data->numEdges - c->firstEdge;
+  }
+
+  unsigned int kept = 0;
+  const char* p = c->begin;
+
+  for (unsigned int i = 0; i < numLines; i++) {
+    unsigned int edge = c->firstEdge + i;
+    unsigned int v, w;
+    double weight = 1.0;
+
+    p = _skipWhite(p, c->end);
+    const char* eol = memchr(p, '\n', (size_t)(c->end - p));
+    if (eol == NULL) eol = c->end;
+
+    const char* q = _parseUnsigned(p, eol, &v);
+    if (q != NULL) q = _parseUnsigned(_skipSpaces(q, eol), eol, &w);
+    if (q == NULL) {
+      c->error = ERROR_EDGE;
+      c->errorEdge = edge;
+      break;
+    }
+
+    /* Os lacetes são ignorados */
+    if (v != w) {
+      if (data->isWeighted && _parseDouble(_skipSpaces(q, eol), eol, &weight) == NULL) {
+        c->error = ERROR_WEIGHT;
+        c->errorEdge = edge;
+        break;
+      }
+      if (v >= data->numVertices || w >= data->numVertices) {
+        c->error = ERROR_VERTEX;
+        c->errorEdge = edge;
+        break;
+      }
+
+      unsigned int pos = c->firstEdge + kept;
+      data->src[pos] = v;
+      data->dst[pos] = w;
+      if (data->isWeighted) {
+        data->weights[pos] = weight;
+      }
+      kept++;
+    }
+
+    p = (eol == c->end) ? eol : eol + 1;
+  }
+
+  c->numKept = kept;
+  return NULL;
+}
+
+/* Executar 'fn' sobre cada um dos pedaços, cada um na sua thread */
+static void _runChunks(void* (*fn)(void*), struct _Chunk* chunks, unsigned int numChunks) {
+#ifdef PARSER_POSIX
+  pthread_t threads[MAX_THREADS];
+  unsigned int started = 0;
+
+  /* O primeiro pedaço é processado por esta thread */
+  for (unsigned int t = 1; t < numChunks; t++) {
+    if (pthread_create(&threads[t], NULL, fn, &chunks[t]) != 0) {
+      break;
+    }
+    started = t;
+  }
+
+  fn(&chunks[0]);
+
+  /* Se alguma thread não pôde ser criada, os pedaços que faltam são processados aqui */
+  for (unsigned int t = started + 1; t < numChunks; t++) {
+    fn(&chunks[t]);
+  }
+  for (unsigned int t = 1; t <= started; t++) {
+    pthread_join(threads[t], NULL);
+  }
+#else
+  for (unsigned int t = 0; t < numChunks; t++) {
+    fn(&chunks[t]);
+  }
+#endif
+}
+
+/* Número de threads a usar para 'size' bytes de texto */
+static unsigned int _numThreads(size_t size) {
+  long cpus = 1;
+#ifdef PARSER_POSIX
+  cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (cpus < 1) cpus = 1;
+  if (cpus > MAX_THREADS) cpus = MAX_THREADS;
+
+  size_t bySize = size / MIN_CHUNK_SIZE + 1;
+  return (bySize < (size_t)cpus) ? (unsigned int)bySize : (unsigned int)cpus;
+}
+
+
+/* Ler um ficheiro de um grafo, a partir da posição atual */
+GraphFileData* GraphFileParse(FILE* f) {
+  assert(f != NULL);
+
+  struct _FileText text;
+  if (!_openText(f, &text)) {
+    return NULL;
+  }
+
+  const char* p = text.begin;
+  const char* end = text.end;
+
+  /* O cabeçalho: orientado?, weighted?, número de vértices e número de arestas */
+  int isDigraph, isWeighted;
+  unsigned int numVertices, numEdges;
+
+  p = _parseInt(_skipWhite(p, end), end, &isDigraph);
+  if (p == NULL) {
+    fprintf(stderr, "Error reading if is digraph\n");
+    _closeText(&text);
+    return NULL;
+  }
+  p = _parseInt(_skipWhite(p, end), end, &isWeighted);
+  if (p == NULL) {
+    fprintf(stderr, "Error reading if is weighted graph\n");
+    _closeText(&text);
+    return NULL;
+  }
+  p = _parseUnsigned(_skipWhite(p, end), end, &numVertices);
+  if (p == NULL) {
+    fprintf(stderr, "Error reading number of vertices\n");
+    _closeText(&text);
+    return NULL;
+  }
+  p = _parseUnsigned(_skipWhite(p, end), end, &numEdges);
+  if (p == NULL) {
+    fprintf(stderr, "Error reading number of edges\n");
+    _closeText(&text);
+    return NULL;
+  }
+
+  GraphFileData* data = (GraphFileData*)malloc(sizeof(GraphFileData));
+  if (data == NULL) abort();
+
+  data->isDigraph = isDigraph;
+  data->isWeighted = isWeighted;
+  data->numVertices = numVertices;
+  data->numEdges = numEdges;
+  data->src = NULL;
+  data->dst = NULL;
+  data->weights = NULL;
+
+  /* Dividir as linhas das arestas em pedaços de tamanho semelhante, terminados em mudanças de linha */
+  struct _Chunk chunks[MAX_THREADS];
+  unsigned int numChunks = _numThreads((size_t)(end - p));
+
+  const char* chunkBegin = p;
+  for (unsigned int t = 0; t < numChunks; t++) {
+    const char* chunkEnd = end;
+    if (t < numChunks - 1) {
+      chunkEnd = chunkBegin + (end - chunkBegin) / (numChunks - t);
+      const char* eol = memchr(chunkEnd, '\n', (size_t)(end - chunkEnd));
+      chunkEnd = (eol == NULL) ? end : eol + 1;
+    }
+
+    chunks[t].begin = chunkBegin;
+    chunks[t].end = chunkEnd;
+    chunks[t].data = data;
+    chunks[t].numLines = 0;
+    chunks[t].numKept = 0;
+    chunks[t].error = ERROR_NONE;
+    chunks[t].errorEdge = 0;
+
+    chunkBegin = chunkEnd;
+  }
+
+  /* 1 - Contar as linhas de cada pedaço e, por somas prefixas, obter o índice da sua primeira aresta */
+  _runChunks(_countLines, chunks, numChunks);
+
+  unsigned int numLines = 0;
+  for (unsigned int t = 0; t < numChunks; t++) {
+    chunks[t].firstEdge = numLines;
+    numLines += chunks[t].numLines;
+  }
+
+  /*
+    Só agora são alocados os arrays das arestas: o número de arestas do cabeçalho pode estar errado
+    (ficheiro truncado ou corrompido), mas nunca há mais arestas para guardar do que linhas no ficheiro
+  */
+  size_t capacity = (numLines < numEdges) ? numLines : numEdges;
+  data->src = (unsigned int*)malloc((capacity + 1) * sizeof(unsigned int));
+  data->dst = (unsigned int*)malloc((capacity + 1) * sizeof(unsigned int));
+  data->weights = isWeighted ? (double*)malloc((capacity + 1) * sizeof(double)) : NULL;
+  if (data->src == NULL || data->dst == NULL || (isWeighted && data->weights == NULL)) abort();
+
+  /* 2 - Ler as arestas de cada pedaço para a sua zona dos arrays */
+  _runChunks(_parseLines, chunks, numChunks);
+
+  /* Houve erros? É reportado o da primeira linha com erro */
+  int error = ERROR_NONE;
+  unsigned int errorEdge = 0;
+  for (unsigned int t = 0; t < numChunks && error == ERROR_NONE; t++) {
+    error = chunks[t].error;
+    errorEdge = chunks[t].errorEdge;
+  }
+  if (error == ERROR_NONE && numLines < numEdges) {
+    error = ERROR_EDGE;
+    errorEdge = numLines;
+  }
+  if (error == ERROR_NONE && numLines > numEdges) {
+    /* O ficheiro tem mais linhas de arestas do que o cabeçalho indica */
+    error = ERROR_EXTRA;
+    errorEdge = numEdges;
+  }
+
+  if (error != ERROR_NONE) {
+    if (error == ERROR_EDGE) {
+      fprintf(stderr, "Error reading edge on line %u\n", 4 + errorEdge + 1);
+    } else if (error == ERROR_WEIGHT) {
+      fprintf(stderr, "Error reading edge weight on line %u\n", 4 + errorEdge + 1);
+    } else if (error == ERROR_EXTRA) {
+      fprintf(stderr, "Unexpected edge on line %u (only %u edges declared)\n", 4 + errorEdge + 1,
+              numEdges);
+    } else {
+      fprintf(stderr, "Invalid vertex on line %u\n", 4 + errorEdge + 1);
+    }
+    GraphFileDataDestroy(&data);
+    _closeText(&text);
+    return NULL;
+  }
+
+  /* 3 - Juntar as zonas dos vários pedaços (os lacetes deixaram "buracos" no fim de cada uma) */
+  unsigned int numKept = 0;
+  for (unsigned int t = 0; t < numChunks; t++) {
+    unsigned int from = chunks[t].firstEdge;
+    unsigned int n = chunks[t].numKept;
+    if (n > 0 && from != numKept) {
+      memmove(&data->src[numKept], &data->src[from], n * sizeof(unsigned int));
+      memmove(&data->dst[numKept], &data->dst[from], n * sizeof(unsigned int));
+      if (isWeighted) {
+        memmove(&data->weights[numKept], &data->weights[from], n * sizeof(double));
+      }
+    }
+    numKept += n;
+  }
+  data->numEdges = numKept;
+
+  _closeText(&text);
+
+  return data;
+}
+
+
+void GraphFileDataDestroy(GraphFileData** p) {
+  assert(*p != NULL);
+  GraphFileData* data = *p;
+
+  free(data->src);
+  free(data->dst);
+  free(data->weights);
+  free(data);
+
+  *p = NULL;
+}
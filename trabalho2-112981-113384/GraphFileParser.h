@@ -0,0 +1,36 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Graph file parser
+//
+// Reads a whole graph file (see GRAPHS/README.txt for the format) into
+// plain arrays, from which a Graph or a GraphCSR can then be built in bulk.
+// The file is mapped into memory and its edge lines are parsed by several
+// threads, each one handling a chunk of whole lines.
+//
+
+#ifndef _GRAPH_FILE_PARSER_
+#define _GRAPH_FILE_PARSER_
+
+#include <stdio.h>
+
+typedef struct _GraphFileData {
+  int isDigraph;
+  int isWeighted;
+  unsigned int numVertices;
+  unsigned int numEdges;  // Edges read, in file order, WITHOUT self-loops
+  unsigned int* src;      // Edge i goes from src[i] ...
+  unsigned int* dst;      // ... to dst[i]
+  double* weights;        // With weight weights[i] (NULL if not weighted)
+} GraphFileData;
+
+//
+// Reads the file from its current position to the end
+// On error, a message is written to stderr and NULL is returned: this
+// includes a file with fewer or more edge lines than its header declares
+//
+GraphFileData* GraphFileParse(FILE* f);
+
+void GraphFileDataDestroy(GraphFileData** p);
+
+#endif  // _GRAPH_FILE_PARSER_
@@ -0,0 +1,351 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Strongly connected components of a digraph (iterative Tarjan)
+//
+
+#include "GraphSCC.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Graph.h"
+#include "instrumentation.h"
+
+struct _GraphSCC {
+  const Graph* graph;
+  unsigned int numVertices;
+  unsigned int numComponents;
+  unsigned int* component;   /* Componente de cada vértice */
+  unsigned int* offsets;     /* Os vértices da componente c estão nas posições [offsets[c], offsets[c+1]) ... */
+  unsigned int* vertices;    /* ... deste array, por ordem crescente */
+  unsigned int* cycle;       /* Um ciclo do grafo (NULL se for acíclico) */
+  unsigned int cycleLength;
+};
+
+/* Definir as macros a serem usadas para a análise da complexidade */
+#define VERTEX_ITER 0
+#define EDGE_ITER 1
+
+/* Vértice ainda não visitado pela pesquisa em profundidade */
+#define UNVISITED UINT_MAX
+
+/*
+  Algoritmo de Tarjan, sem recursão: a pilha de chamadas é simulada com dois arrays, com o vértice de cada
+  chamada e a posição, nos seus adjacentes, do próximo a visitar. Preenche p->component com o número de cada
+  componente pela ordem em que são fechadas (que é a ordem topológica inversa da condensação)
+*/
+static void _tarjan(GraphSCC* p) {
+  unsigned int n = p->numVertices;
+
+  /* "+ 1" para nunca pedir 0 bytes */
+  unsigned int* index = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  unsigned int* lowLink = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  char* onStack = (char*)calloc(n + 1, sizeof(char));
+  unsigned int* stack = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  unsigned int* callVertex = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  unsigned int* callPosition = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  if (index == NULL || lowLink == NULL || onStack == NULL || stack == NULL || callVertex == NULL ||
+      callPosition == NULL) {
+    abort();
+  }
+
+  for (unsigned int v = 0; v < n; v++) {
+    index[v] = UNVISITED;
+  }
+
+  unsigned int counter = 0;
+  unsigned int top = 0;
+  p->numComponents = 0;
+
+  for (unsigned int s = 0; s < n; s++) {
+    if (index[s] != UNVISITED) continue;
+
+    /* "Chamar" a pesquisa a partir de 's' */
+    unsigned int calls = 0;
+    index[s] = lowLink[s] = counter++;
+    stack[top++] = s;
+    onStack[s] = 1;
+    callVertex[calls] = s;
+    callPosition[calls] = 0;
+    calls++;
+
+    while (calls > 0) {
+      unsigned int v = callVertex[calls - 1];
+      GraphAdjacents adj = GraphGetAdjacents(p->graph, v);
+
+      if (callPosition[calls - 1] < adj.numAdjacents) {
+        /* Visitar o próximo adjacente de 'v' */
+        unsigned int w = adj.vertices[callPosition[calls - 1]++];
+        InstrInc(EDGE_ITER);
+
+        if (index[w] == UNVISITED) {
+          index[w] = lowLink[w] = counter++;
+          stack[top++] = w;
+          onStack[w] = 1;
+          callVertex[calls] = w;
+          callPosition[calls] = 0;
+          calls++;
+        } else if (onStack[w] && index[w] < lowLink[v]) {
+          lowLink[v] = index[w];
+        }
+        continue;
+      }
+
+      /* Todos os adjacentes de 'v' foram visitados: "regressar" ao vértice que o chamou */
+      InstrInc(VERTEX_ITER);
+      calls--;
+      if (calls > 0) {
+        unsigned int u = callVertex[calls - 1];
+        if (lowLink[v] < lowLink[u]) lowLink[u] = lowLink[v];
+      }
+
+      /* 'v' é a raiz de uma componente: esta é formada pelos vértices acima dele na pilha */
+      if (lowLink[v] == index[v]) {
+        unsigned int w;
+        do {
+          w = stack[--top];
+          onStack[w] = 0;
+          p->component[w] = p->numComponents;
+        } while (w != v);
+        p->numComponents++;
+      }
+    }
+  }
+
+  free(index);
+  free(lowLink);
+  free(onStack);
+  free(stack);
+  free(callVertex);
+  free(callPosition);
+}
+
+/*
+  Encontrar um ciclo na primeira componente com mais de um vértice (não há lacetes): pesquisa em largura,
+  dentro da componente, a partir do seu primeiro vértice 's', até encontrar uma aresta que regressa a 's'.
+  O ciclo obtido é o mais curto dos que passam por 's'
+*/
+static void _findCycle(GraphSCC* p) {
+  unsigned int c = 0;
+  while (c < p->numComponents && p->offsets[c + 1] - p->offsets[c] < 2) c++;
+  if (c == p->numComponents) return;
+
+  unsigned int n = p->numVertices;
+  unsigned int s = p->vertices[p->offsets[c]];
+
+  unsigned int* parent = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  unsigned int* queue = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  if (parent == NULL || queue == NULL) abort();
+
+  for (unsigned int k = p->offsets[c]; k < p->offsets[c + 1]; k++) {
+    parent[p->vertices[k]] = UNVISITED;
+  }
+
+  unsigned int head = 0;
+  unsigned int tail = 0;
+  unsigned int last = UNVISITED;
+  queue[tail++] = s;
+  parent[s] = s;
+
+  while (head < tail && last == UNVISITED) {
+    unsigned int v = queue[head++];
+    GraphAdjacents adj = GraphGetAdjacents(p->graph, v);
+
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+      unsigned int w = adj.vertices[j];
+      InstrInc(EDGE_ITER);
+
+      if (w == s) {
+        last = v;   /* O ciclo é s -> ... -> v -> s */
+        break;
+      }
+      if (p->component[w] == c && parent[w] == UNVISITED) {
+        parent[w] = v;
+        queue[tail++] = w;
+      }
+    }
+  }
+  assert(last != UNVISITED);
+
+  /* Contar os vértices do caminho de 's' até 'last' e guardá-los, percorrendo-o de trás para a frente */
+  unsigned int length = 1;
+  for (unsigned int v = last; v != s; v = parent[v]) length++;
+
+  p->cycle = (unsigned int*)malloc(length * sizeof(unsigned int));
+  if (p->cycle == NULL) abort();
+  p->cycleLength = length;
+
+  unsigned int k = length;
+  for (unsigned int v = last; v != s; v = parent[v]) {
+    p->cycle[--k] = v;
+  }
+  p->cycle[0] = s;
+
+  free(parent);
+  free(queue);
+}
+
+
+GraphSCC* GraphSCCCompute(const Graph* g) {
+  assert(g != NULL && GraphIsDigraph(g) == 1);
+
+  GraphSCC* p = (GraphSCC*)malloc(sizeof(struct _GraphSCC));
+  if (p == NULL) abort();
+
+  unsigned int n = GraphGetNumVertices(g);
+  p->graph = g;
+  p->numVertices = n;
+  p->cycle = NULL;
+  p->cycleLength = 0;
+
+  p->component = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  p->vertices = (unsigned int*)malloc((n + 1) * sizeof(unsigned int));
+  if (p->component == NULL || p->vertices == NULL) abort();
+
+  _tarjan(p);
+
+  /* Renumerar as componentes, para ficarem pela ordem topológica da condensação */
+  for (unsigned int v = 0; v < n; v++) {
+    p->component[v] = p->numComponents - 1 - p->component[v];
+  }
+
+  /* Agrupar os vértices por componente (ordenação por contagem, pelo que ficam por ordem crescente) */
+  p->offsets = (unsigned int*)calloc(p->numComponents + 2, sizeof(unsigned int));
+  if (p->offsets == NULL) abort();
+
+  for (unsigned int v = 0; v < n; v++) {
+    p->offsets[p->component[v] + 2]++;
+  }
+  for (unsigned int c = 0; c < p->numComponents; c++) {
+    p->offsets[c + 2] += p->offsets[c + 1];
+  }
+  for (unsigned int v = 0; v < n; v++) {
+    p->vertices[p->offsets[p->component[v] + 1]++] = v;
+  }
+
+  _findCycle(p);
+
+  return p;
+}
+
+
+void GraphSCCDestroy(GraphSCC** p) {
+  assert(*p != NULL);
+
+  GraphSCC* aux = *p;
+
+  free(aux->component);
+  free(aux->offsets);
+  free(aux->vertices);
+  free(aux->cycle);
+
+  free(*p);
+  *p = NULL;
+}
+
+
+// Components
+
+unsigned int GraphSCCGetNumComponents(const GraphSCC* p) {
+  assert(p != NULL);
+  return p->numComponents;
+}
+
+unsigned int GraphSCCGetComponent(const GraphSCC* p, unsigned int v) {
+  assert(p != NULL && v < p->numVertices);
+  return p->component[v];
+}
+
+unsigned int GraphSCCGetComponentSize(const GraphSCC* p, unsigned int c) {
+  assert(p != NULL && c < p->numComponents);
+  return p->offsets[c + 1] - p->offsets[c];
+}
+
+const unsigned int* GraphSCCGetComponentVertices(const GraphSCC* p, unsigned int c) {
+  assert(p != NULL && c < p->numComponents);
+  return &p->vertices[p->offsets[c]];
+}
+
+
+// Cycles
+
+int GraphSCCIsAcyclic(const GraphSCC* p) {
+  assert(p != NULL);
+  return p->numComponents == p->numVertices;
+}
+
+const unsigned int* GraphSCCGetCycle(const GraphSCC* p, unsigned int* length) {
+  assert(p != NULL && length != NULL);
+  *length = p->cycleLength;
+  return p->cycle;
+}
+
+
+// Condensation
+
+Graph* GraphSCCGetCondensation(const GraphSCC* p) {
+  assert(p != NULL);
+
+  Graph* condensation = GraphCreate(p->numComponents, 1, 0);
+
+  /* As arestas entre componentes diferentes (as repetidas são descartadas por GraphAddEdgesBatch) */
+  size_t numEdges = GraphGetNumEdges(p->graph);
+  unsigned int* src = (unsigned int*)malloc((numEdges + 1) * sizeof(unsigned int));
+  unsigned int* dst = (unsigned int*)malloc((numEdges + 1) * sizeof(unsigned int));
+  if (src == NULL || dst == NULL) abort();
+
+  size_t k = 0;
+  for (unsigned int v = 0; v < p->numVertices; v++) {
+    GraphAdjacents adj = GraphGetAdjacents(p->graph, v);
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+      unsigned int c = p->component[v];
+      unsigned int d = p->component[adj.vertices[j]];
+      if (c != d) {
+        src[k] = c;
+        dst[k] = d;
+        k++;
+      }
+    }
+  }
+
+  GraphAddEdgesBatch(condensation, src, dst, NULL, k);
+
+  free(src);
+  free(dst);
+
+  return condensation;
+}
+
+
+// DISPLAYING on the console
+
+void GraphSCCDisplay(const GraphSCC* p) {
+  assert(p != NULL);
+
+  printf("Strongly connected components: %u\n", p->numComponents);
+  for (unsigned int c = 0; c < p->numComponents; c++) {
+    printf("%2u:", c);
+    for (unsigned int k = p->offsets[c]; k < p->offsets[c + 1]; k++) {
+      printf(" %u", p->vertices[k]);
+    }
+    printf("\n");
+  }
+}
+
+void GraphSCCDisplayCycle(const GraphSCC* p) {
+  assert(p != NULL);
+
+  if (p->cycle == NULL) {
+    printf("No cycles\n");
+    return;
+  }
+
+  printf("Cycle:");
+  for (unsigned int k = 0; k < p->cycleLength; k++) {
+    printf(" %u ->", p->cycle[k]);
+  }
+  printf(" %u\n", p->cycle[0]);
+}
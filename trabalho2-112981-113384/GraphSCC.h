@@ -0,0 +1,75 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Strongly connected components of a digraph
+//
+// Computed with an iterative (non-recursive) version of Tarjan's algorithm,
+// in O(V + E) time and without using the call stack, so that it can be used
+// on graphs with millions of vertices.
+//
+// The components are numbered in topological order of the condensation:
+// every edge between different components goes from a lower to a higher
+// component number. When the digraph is not acyclic, a cycle is also
+// extracted, as a witness.
+//
+
+#ifndef _GRAPH_SCC_
+#define _GRAPH_SCC_
+
+#include "Graph.h"
+
+typedef struct _GraphSCC GraphSCC;
+
+GraphSCC* GraphSCCCompute(const Graph* g);
+
+void GraphSCCDestroy(GraphSCC** p);
+
+// Components
+
+unsigned int GraphSCCGetNumComponents(const GraphSCC* p);
+
+//
+// The component of vertex v
+//
+unsigned int GraphSCCGetComponent(const GraphSCC* p, unsigned int v);
+
+unsigned int GraphSCCGetComponentSize(const GraphSCC* p, unsigned int c);
+
+//
+// returns a pointer to the GraphSCCGetComponentSize(p, c) vertices of
+// component c, sorted by index
+// the array belongs to the GraphSCC: DO NOT FREE IT
+//
+const unsigned int* GraphSCCGetComponentVertices(const GraphSCC* p,
+                                                 unsigned int c);
+
+// Cycles
+
+//
+// The digraph is acyclic iff every component has a single vertex
+//
+int GraphSCCIsAcyclic(const GraphSCC* p);
+
+//
+// returns a cycle v0 -> v1 -> ... -> v(k-1) -> v0, storing k in *length,
+// or NULL (and 0) if the digraph is acyclic
+// the array belongs to the GraphSCC: DO NOT FREE IT
+//
+const unsigned int* GraphSCCGetCycle(const GraphSCC* p, unsigned int* length);
+
+// Condensation
+
+//
+// returns a new (unweighted) digraph with one vertex per component, and an
+// edge (c, d) if there is an edge from a vertex of c to a vertex of d
+// It is a DAG, and 0, 1, ..., numComponents - 1 is a topological order
+//
+Graph* GraphSCCGetCondensation(const GraphSCC* p);
+
+// DISPLAYING on the console
+
+void GraphSCCDisplay(const GraphSCC* p);
+
+void GraphSCCDisplayCycle(const GraphSCC* p);
+
+#endif  // _GRAPH_SCC_
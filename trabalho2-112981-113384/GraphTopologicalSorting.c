@@ -7,10 +7,19 @@
 #include "GraphTopologicalSorting.h"
 
 #include <assert.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#if defined(__linux__) || defined(__APPLE__)
+#define TOPO_POSIX 1
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 #include "Graph.h"
+#include "GraphCSR.h"
+#include "IntegersHeap.h"
 #include "IntegersQueue.h"
 #include "instrumentation.h"
 
@@ -20,22 +29,25 @@ struct _GraphTopoSort {
   unsigned int* vertexSequence;    // The result  -> Ordem topológica dos vértices 
   int validResult;                 // 0 or 1      -> Dá para ordenar?
   unsigned int numVertices;        // From the graph
-  Graph* graph;
+  const Graph* graph;
+  const GraphCSR* csr;             // Instead of graph, for the CSR versions
+  unsigned int* level;             // V4 only    -> Nível (frente de onda) de cada vértice
+  unsigned int* levelSizes;        // V4 only    -> Número de vértices de cada nível
+  unsigned int numLevels;          // V4 only
+  unsigned int numThreads;         // Maior número de threads usadas ao mesmo tempo (1 nas versões sequenciais)
 };
 
 /* Definir as macros a serem usadas para a análise da complexidade */
-#define VERTEX_ITER InstrCount[0] // Número de iterações do ciclo que percorre os vértices
-#define EDGE_ITER InstrCount[1]   // Número de iterações do ciclo que percorre as arestas
-#define EDGE_REM InstrCount[2]    // Número de arestas removidas
+#define VERTEX_ITER 0 // Número de iterações do ciclo que percorre os vértices
+#define EDGE_ITER 1   // Número de iterações do ciclo que percorre as arestas
+#define EDGE_REM 2    // Número de arestas removidas
 
 // AUXILIARY FUNCTION
 // Allocate memory for the struct
 // And for its array fields
 // Initialize all struct fields
 //
-static GraphTopoSort* _create(Graph* g) {
-  assert(g != NULL);
-
+static GraphTopoSort* _alloc(unsigned int numVertices) {
   /* Alocar memória para a estrutura GraphTopoSort */
   GraphTopoSort* p = (GraphTopoSort*)malloc(sizeof(struct _GraphTopoSort));
 
@@ -46,7 +58,7 @@ static GraphTopoSort* _create(Graph* g) {
   }
 
   /* Definir o número de vértices para a estrutura */
-  p->numVertices = GraphGetNumVertices(g);
+  p->numVertices = numVertices;
 
   /* Alocar memória para os arrays */
   p->marked = (int*) malloc(p->numVertices * sizeof(int));
@@ -64,7 +76,12 @@ static GraphTopoSort* _create(Graph* g) {
   }
 
   /* Inicializar as variáveis de GraphTopoSort */
-  p->graph = g;
+  p->graph = NULL;
+  p->csr = NULL;
+  p->level = NULL;
+  p->levelSizes = NULL;
+  p->numLevels = 0;
+  p->numThreads = 1;
   p->validResult = 0;
 
   /* Inicializar os arrays */
@@ -72,56 +89,93 @@ static GraphTopoSort* _create(Graph* g) {
   for (unsigned int i = 0; i < p->numVertices; i++) {
     p->marked[i] = 0;
     p->vertexSequence[i] = 0;
+  }
+
+  return p;
+}
+
+static GraphTopoSort* _create(const Graph* g) {
+  assert(g != NULL);
+
+  GraphTopoSort* p = _alloc(GraphGetNumVertices(g));
+  if (p == NULL) return NULL;
+
+  p->graph = g;
+
+  /* Os graus de entrada dos vértices são o ponto de partida de todos os algoritmos */
+  for (unsigned int i = 0; i < p->numVertices; i++) {
     p->numIncomingEdges[i] = GraphGetVertexInDegree(g, i);
   }
 
   return p;
 }
 
+static GraphTopoSort* _createCSR(const GraphCSR* g) {
+  assert(g != NULL);
+
+  GraphTopoSort* p = _alloc(GraphCSRGetNumVertices(g));
+  if (p == NULL) return NULL;
+
+  p->csr = g;
+
+  for (unsigned int i = 0; i < p->numVertices; i++) {
+    p->numIncomingEdges[i] = GraphCSRGetVertexInDegree(g, i);
+  }
+
+  return p;
+}
+
 //
 // Computing the topological sorting, if any, using the 1st algorithm:
-// 1 - Create a copy of the graph
+// 1 - Create a degree overlay of the graph (in and out degrees only)
 // 2 - Successively identify vertices without incoming edges and remove their
-//     outgoing edges
+//     outgoing edges from the overlay
 // Check if a valid sorting was computed and set the isValid field
 // For instance, by checking if the number of elements in the vertexSequence is
 // the number of graph vertices
 //
-GraphTopoSort* GraphTopoSortComputeV1(Graph* g) {
+GraphTopoSort* GraphTopoSortComputeV1(const Graph* g) {
   assert(g != NULL && GraphIsDigraph(g) == 1);
 
   // Create and initialize the struct
 
   GraphTopoSort* topoSort = _create(g);
 
-  /* Criar uma cópia do grafo original */
-  Graph* gCopy = GraphCopy(g);
-  assert(GraphCheckInvariants(gCopy) == 1); // Confirmar se o grafo é válido
+  /*
+    Em vez de uma cópia do grafo, uma sobreposição (overlay) dos seus graus: os graus de entrada são os de
+    numIncomingEdges e os de saída ficam em outDegree. Remover uma aresta é apenas atualizar estes contadores,
+    sem alterar (nem copiar) os arrays das arestas, que continuam a ser lidos do grafo original
+  */
+  unsigned int* outDegree = (unsigned int*)malloc((GraphGetNumVertices(g) + 1) * sizeof(unsigned int));
 
-  /* Verificar a correta criação da cópia do grafo */
-  if (gCopy == NULL) {
-    /* Caso não tenha sido possível criar a cópia do grafo, libertar a memória alocada e retornar NULL */
+  /* Verificar a correta alocação da sobreposição */
+  if (outDegree == NULL) {
+    /* Caso não tenha sido possível alocá-la, libertar a memória alocada e retornar NULL */
     GraphTopoSortDestroy(&topoSort);
     return NULL;
   }
 
+  for (unsigned int i = 0; i < GraphGetNumVertices(g); i++) {
+    outDegree[i] = GraphGetVertexOutDegree(g, i);
+  }
+
   /* Declarar a variável que irá contar o número de vértices adicionados (serve também de índice) */
   unsigned int addedVertices = 0;
 
   /* Repetir até preencher vertexSequence */
-  while (addedVertices < GraphGetNumVertices(gCopy)) {
+  while (addedVertices < GraphGetNumVertices(g)) {
 
     /* Variável que verifica se foi encontrado um vértice sem arestas incidentes (no caso de não ser encontrado o grafo possui ciclos) */
     int foundVertex = 0;
 
     /* Percorrer todos os vértices do grafo */
-    for (unsigned int i = 0; i < GraphGetNumVertices(gCopy); i++) {
+    for (unsigned int i = 0; i < GraphGetNumVertices(g); i++) {
 
       /* Incrementar o contador VERTEX_ITER */
-      VERTEX_ITER++;
+      InstrInc(VERTEX_ITER);
 
       /* Verificar se o vértice ainda não foi adicionado e se não tem arestas incidentes*/
-      if (topoSort->marked[i] == 0 && GraphGetVertexInDegree(gCopy, i) == 0) {
+      if (topoSort->marked[i] == 0 && topoSort->numIncomingEdges[i] == 0) {
 
         /* Caso a condição acima se verifique, adicionar o vértice ao array vertexSequence */
         topoSort->vertexSequence[addedVertices] = i;
@@ -135,31 +189,25 @@ GraphTopoSort* GraphTopoSortComputeV1(Graph* g) {
         /* Assinalar o vértice como "marked" */
         topoSort->marked[i] = 1;
 
-        /* Obter o array com os vértices adjacentes a este */
-        unsigned int* adjacents = GraphGetAdjacentsTo(gCopy, i);
-
         /* 
-          Percorrer todos os vértices adjacentes
-          Nota: o primeiro elemento do array 'adjacents' é o número de vértices adjacentes 
-          Por isso começa-se a iteração com j = 1 
+          Remover todas as arestas que saem do vértice, da sobreposição, removendo-se sempre a última
+          (as arestas ainda não removidas de 'i' são as primeiras outDegree[i] dos seus adjacentes)
         */
-        for (unsigned int j = 1; j <= adjacents[0]; j++) {
+        GraphAdjacents adj = GraphGetAdjacents(g, i);
+        while (outDegree[i] > 0) {
 
           /* Incrementar o contador EDGE_ITER */
-          EDGE_ITER++;
+          InstrInc(EDGE_ITER);
 
           /* Remover aresta */
-          GraphRemoveEdge(gCopy, i, adjacents[j]);
-          assert(GraphCheckInvariants(gCopy) == 1); // Confirmar se o grafo continua válido
+          outDegree[i]--;
+          topoSort->numIncomingEdges[adj.vertices[outDegree[i]]]--;
 
           /* Incrementar o contador EDGE_REM */
-          EDGE_REM++;
+          InstrInc(EDGE_REM);
 
         }
 
-        /* Libertar a memória alocada para o array de vértices adjacentes */
-        free(adjacents);
-
         break;
       }
     }
@@ -175,13 +223,13 @@ GraphTopoSort* GraphTopoSortComputeV1(Graph* g) {
   }
 
   /* Verificar se o número de vértices adicionados é igual ao número de vértices do grafo */
-  if (addedVertices == GraphGetNumVertices(gCopy)) {
+  if (addedVertices == GraphGetNumVertices(g)) {
     /* O resultado é válido */
     topoSort->validResult = 1;
   }
 
-  /* Libertar a memória alocada para a cópia do grafo */
-  GraphDestroy(&gCopy);
+  /* Libertar a memória alocada para a sobreposição */
+  free(outDegree);
 
   /* Devovler a estrutura com os dados da ordem topológica */
   return topoSort;
@@ -193,7 +241,7 @@ GraphTopoSort* GraphTopoSortComputeV1(Graph* g) {
 // For instance, by checking if the number of elements in the vertexSequence is
 // the number of graph vertices
 //
-GraphTopoSort* GraphTopoSortComputeV2(Graph* g) {
+GraphTopoSort* GraphTopoSortComputeV2(const Graph* g) {
   assert(g != NULL && GraphIsDigraph(g) == 1);
 
   // Create and initialize the struct
@@ -213,7 +261,7 @@ GraphTopoSort* GraphTopoSortComputeV2(Graph* g) {
     for (unsigned int i = 0; i < GraphGetNumVertices(g); i++) {
 
       /* Incrementar o contador VERTEX_ITER */
-      VERTEX_ITER++;
+      InstrInc(VERTEX_ITER);
 
       /* Verificar se o vértice ainda não foi adicionado e se não tem arestas incidentes*/
       if (topoSort->marked[i] == 0 && topoSort->numIncomingEdges[i] == 0) {
@@ -230,30 +278,23 @@ GraphTopoSort* GraphTopoSortComputeV2(Graph* g) {
         /* Assinalar o vértice como "marked" */
         topoSort->marked[i] = 1;
 
-        /* Array com os vértices adjacentes */
-        unsigned int* adjacents = GraphGetAdjacentsTo(g, i);
+        /* Vértices adjacentes, lidos diretamente do grafo (sem cópia) */
+        GraphAdjacents adj = GraphGetAdjacents(g, i);
 
-        /* 
-          Percorrer todos os vértices adjacentes
-          Nota: o primeiro elemento do array adjacents é o número de vértices adjacentes 
-          Por isso começa-se a iteração com j = 1
-        */
-        for (unsigned int j = 1; j <= adjacents[0]; j++) {
+        /* Percorrer todos os vértices adjacentes */
+        for (unsigned int j = 0; j < adj.numAdjacents; j++) {
 
           /* Incrementar o contador EDGE_ITER */
-          EDGE_ITER++;
+          InstrInc(EDGE_ITER);
 
           /* Decrementar o número de arestas incidentes */
-          topoSort->numIncomingEdges[adjacents[j]]--;
+          topoSort->numIncomingEdges[adj.vertices[j]]--;
 
           /* Incrementar o contador EDGE_REM */
-          EDGE_REM++;
+          InstrInc(EDGE_REM);
 
         }
 
-        /* Libertar a memória alocada para o array de vértices adjacentes */
-        free(adjacents);
-
         break;
       }
     }
@@ -283,7 +324,7 @@ GraphTopoSort* GraphTopoSortComputeV2(Graph* g) {
 // For instance, by checking if the number of elements in the vertexSequence is
 // the number of graph vertices
 //
-GraphTopoSort* GraphTopoSortComputeV3(Graph* g) {
+GraphTopoSort* GraphTopoSortComputeV3(const Graph* g) {
   assert(g != NULL && GraphIsDigraph(g) == 1);
 
   // Create and initialize the struct
@@ -297,7 +338,7 @@ GraphTopoSort* GraphTopoSortComputeV3(Graph* g) {
   for (unsigned int i = 0; i < GraphGetNumVertices(g); i++) {
 
     /* Incrementar o contador VERTEX_ITER */
-    VERTEX_ITER++;
+    InstrInc(VERTEX_ITER);
 
     if (topoSort->numIncomingEdges[i] == 0) {
       QueueEnqueue(q, i);
@@ -319,36 +360,31 @@ GraphTopoSort* GraphTopoSortComputeV3(Graph* g) {
     /* Incrementar o número de vértices adicionados */
     addedVertices++;
 
-    /* Array com os vértices adjacentes */
-    unsigned int* adjacents = GraphGetAdjacentsTo(g, v);
+    /* Vértices adjacentes, lidos diretamente do grafo (sem cópia) */
+    GraphAdjacents adj = GraphGetAdjacents(g, v);
 
-    /*
-    Percorrer todos os vértices adjacentes
-    Nota: o primeiro elemento do array adjacents é o número de vértices adjacentes
-    Por isso começa-se a iteração com j = 1
-    */
-    for (unsigned int j = 1; j <= adjacents[0]; j++) {
+    /* Percorrer todos os vértices adjacentes */
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+
+      unsigned int w = adj.vertices[j];
 
       /* Incrementar o contador EDGE_ITER */
-      EDGE_ITER++;
+      InstrInc(EDGE_ITER);
 
       /* Decrementar o número de arestas incidentes */
-      topoSort->numIncomingEdges[adjacents[j]]--;
+      topoSort->numIncomingEdges[w]--;
 
       /* Incrementar o contador EDGE_REM */
-      EDGE_REM++;
+      InstrInc(EDGE_REM);
 
       /* Verificar se o vértice fica com inDegree == 0 após decrementar o número de arestas incidentes */
-      if (topoSort->numIncomingEdges[adjacents[j]] == 0) {
+      if (topoSort->numIncomingEdges[w] == 0) {
         /* Adicionar o vértice à fila */
-        QueueEnqueue(q, adjacents[j]);
+        QueueEnqueue(q, w);
       }
 
     }
 
-    /* Libertar a memória alocada para o array de vértices adjacentes */
-    free(adjacents);
-
   }
 
   /* Verificar se o número de vértices adicionados é igual ao número de vértices do grafo */
@@ -363,6 +399,472 @@ GraphTopoSort* GraphTopoSortComputeV3(Graph* g) {
   return topoSort;
 }
 
+//
+// Computing the topological sorting, if any, using the 3rd algorithm over the
+// CSR representation (built from a Graph or a file, or loaded from a
+// snapshot): the in-degrees come precomputed with it, and the adjacents of
+// consecutive vertices are consecutive in one array, instead of being in
+// blocks scattered over the Graph's edge arena
+//
+GraphTopoSort* GraphTopoSortComputeV3CSR(const GraphCSR* g) {
+  assert(g != NULL && GraphCSRIsDigraph(g) == 1);
+
+  // Create and initialize the struct
+
+  GraphTopoSort* topoSort = _createCSR(g);
+
+  unsigned int numVertices = GraphCSRGetNumVertices(g);
+
+  /* Criar uma fila e adicionar-lhe os vértices com inDegree == 0 */
+  Queue* q = QueueCreate(numVertices);
+
+  for (unsigned int i = 0; i < numVertices; i++) {
+
+    /* Incrementar o contador VERTEX_ITER */
+    InstrInc(VERTEX_ITER);
+
+    if (topoSort->numIncomingEdges[i] == 0) {
+      QueueEnqueue(q, i);
+    }
+  }
+
+  unsigned int addedVertices = 0;
+
+  /* Repetir até a fila estar vazia */
+  while (!QueueIsEmpty(q)) {
+
+    unsigned int v = QueueDequeue(q);
+
+    topoSort->vertexSequence[addedVertices] = v;
+    addedVertices++;
+
+    /* Os adjacentes de 'v' estão em posições consecutivas do array partilhado por todos os vértices */
+    GraphAdjacents adj = GraphCSRGetAdjacents(g, v);
+
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+
+      unsigned int w = adj.vertices[j];
+
+      /* Incrementar o contador EDGE_ITER */
+      InstrInc(EDGE_ITER);
+
+      /* Decrementar o número de arestas incidentes */
+      topoSort->numIncomingEdges[w]--;
+
+      /* Incrementar o contador EDGE_REM */
+      InstrInc(EDGE_REM);
+
+      /* Verificar se o vértice fica com inDegree == 0 */
+      if (topoSort->numIncomingEdges[w] == 0) {
+        QueueEnqueue(q, w);
+      }
+    }
+  }
+
+  /* Verificar se o número de vértices adicionados é igual ao número de vértices do grafo */
+  if (addedVertices == numVertices) {
+    topoSort->validResult = 1;
+  }
+
+  /* Destruir a fila */
+  QueueDestroy(&q);
+
+  return topoSort;
+}
+
+
+// AUXILIARY DATA and FUNCTIONS for the 4th algorithm
+
+/* Número máximo de threads, e número mínimo de vértices de um nível para que este seja repartido entre elas */
+#define MAX_THREADS 16
+#define MIN_PARALLEL_LEVEL (1 << 12)
+
+/* Número de vértices da frente de onda que uma thread retira de cada vez, e tamanho do seu buffer de vértices novos */
+#define GRAB_SIZE 64
+#define BUFFER_SIZE 256
+
+/* Dados partilhados pelas threads que processam um nível */
+struct _LevelWork {
+  const Graph* graph;
+  _Atomic unsigned int* inDegree;  /* Graus de entrada ainda por "remover" */
+  unsigned int* frontier;          /* Frentes de onda, umas a seguir às outras (é o array vertexSequence) */
+  unsigned int* level;             /* Nível de cada vértice */
+  unsigned int nextLevel;          /* Nível dos vértices que ficarem sem arestas incidentes */
+  unsigned int end;                /* Fim da frente de onda atual */
+  atomic_uint next;                /* Próxima posição da frente de onda atual a processar */
+  atomic_uint tail;                /* Fim da próxima frente de onda */
+};
+
+/* Dados de cada thread */
+struct _LevelWorker {
+  struct _LevelWork* work;
+  struct _LevelPool* pool;
+  unsigned long edgeIter;          /* Contadores locais, somados aos globais no fim (não são atómicos) */
+};
+
+#ifdef TOPO_POSIX
+/* Barreira (pthread_barrier_t não existe em todos os sistemas POSIX): espera até 'count' threads a atingirem */
+struct _Barrier {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  unsigned int count;              /* Número de threads que a usam */
+  unsigned int waiting;            /* Número de threads à espera */
+  unsigned int generation;         /* Incrementado sempre que as threads são libertadas */
+};
+
+/*
+  Threads criadas uma única vez, no primeiro nível largo, e reutilizadas nos seguintes: em cada nível largo,
+  todas passam uma barreira no início e outra no fim (nos níveis estreitos ficam bloqueadas, sem gastar CPU)
+*/
+struct _LevelPool {
+  pthread_t threads[MAX_THREADS];
+  unsigned int numThreads;         /* Incluindo a thread que executa o algoritmo (0 se ainda não foi criado) */
+  int stop;                        /* Para as threads terminarem, em vez de processarem mais um nível */
+  struct _Barrier barrier;
+};
+#endif
+
+/* Acrescentar os vértices do buffer à próxima frente de onda, reservando de uma só vez o seu lugar */
+static void _flushFrontier(struct _LevelWork* work, const unsigned int* buffer, unsigned int count) {
+  unsigned int pos = atomic_fetch_add_explicit(&work->tail, count, memory_order_relaxed);
+  for (unsigned int k = 0; k < count; k++) {
+    work->frontier[pos + k] = buffer[k];
+  }
+}
+
+/* Processar vértices da frente de onda atual, GRAB_SIZE de cada vez, até esta se esgotar */
+static void* _processLevel(void* arg) {
+  struct _LevelWorker* worker = (struct _LevelWorker*)arg;
+  struct _LevelWork* work = worker->work;
+
+  unsigned int buffer[BUFFER_SIZE];
+  unsigned int count = 0;
+
+  for (;;) {
+    unsigned int begin = atomic_fetch_add_explicit(&work->next, GRAB_SIZE, memory_order_relaxed);
+    if (begin >= work->end) break;
+    unsigned int end = (begin + GRAB_SIZE < work->end) ? begin + GRAB_SIZE : work->end;
+
+    for (unsigned int k = begin; k < end; k++) {
+      GraphAdjacents adj = GraphGetAdjacents(work->graph, work->frontier[k]);
+
+      for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+        unsigned int w = adj.vertices[j];
+        worker->edgeIter++;
+
+        /* Só a thread que remove a última aresta incidente em 'w' o acrescenta à próxima frente de onda */
+        if (atomic_fetch_sub_explicit(&work->inDegree[w], 1, memory_order_acq_rel) == 1) {
+          work->level[w] = work->nextLevel;
+          buffer[count++] = w;
+          if (count == BUFFER_SIZE) {
+            _flushFrontier(work, buffer, count);
+            count = 0;
+          }
+        }
+      }
+    }
+  }
+
+  if (count > 0) {
+    _flushFrontier(work, buffer, count);
+  }
+  return NULL;
+}
+
+/* Número de threads a usar */
+static unsigned int _numThreads(void) {
+  long cpus = 1;
+#ifdef TOPO_POSIX
+  cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (cpus < 1) cpus = 1;
+  if (cpus > MAX_THREADS) cpus = MAX_THREADS;
+  return (unsigned int)cpus;
+}
+
+#ifdef TOPO_POSIX
+static void _barrierWait(struct _Barrier* b) {
+  pthread_mutex_lock(&b->mutex);
+  unsigned int generation = b->generation;
+  if (++b->waiting == b->count) {
+    /* A última a chegar liberta as outras */
+    b->waiting = 0;
+    b->generation++;
+    pthread_cond_broadcast(&b->cond);
+  } else {
+    while (generation == b->generation) {
+      pthread_cond_wait(&b->cond, &b->mutex);
+    }
+  }
+  pthread_mutex_unlock(&b->mutex);
+}
+
+/* Ciclo de cada thread do pool: processar um nível sempre que a barreira do seu início é passada */
+static void* _poolWorker(void* arg) {
+  struct _LevelWorker* worker = (struct _LevelWorker*)arg;
+  struct _LevelPool* pool = worker->pool;
+
+  for (;;) {
+    _barrierWait(&pool->barrier);
+    if (pool->stop) break;
+    _processLevel(worker);
+    _barrierWait(&pool->barrier);
+  }
+  return NULL;
+}
+
+/* Criar as threads do pool (até numThreads - 1, além desta), devolvendo quantas threads o pool tem ao todo */
+static unsigned int _poolStart(struct _LevelPool* pool, struct _LevelWorker* workers, unsigned int numThreads) {
+  pool->stop = 0;
+  pthread_mutex_init(&pool->barrier.mutex, NULL);
+  pthread_cond_init(&pool->barrier.cond, NULL);
+  pool->barrier.waiting = 0;
+  pool->barrier.generation = 0;
+
+  /* As threads já criadas esperam na barreira, que só é completada por esta thread, depois de 'count' ser o certo */
+  pool->barrier.count = MAX_THREADS + 1;
+
+  unsigned int started = 0;
+  for (unsigned int t = 1; t < numThreads; t++) {
+    workers[t].pool = pool;
+    if (pthread_create(&pool->threads[t], NULL, _poolWorker, &workers[t]) != 0) {
+      break;
+    }
+    started = t;
+  }
+
+  pthread_mutex_lock(&pool->barrier.mutex);
+  pool->barrier.count = started + 1;
+  pthread_mutex_unlock(&pool->barrier.mutex);
+
+  pool->numThreads = started + 1;
+  return pool->numThreads;
+}
+
+/* Processar a frente de onda atual com todas as threads do pool (a primeira é esta) */
+static void _poolRunLevel(struct _LevelPool* pool, struct _LevelWorker* workers) {
+  _barrierWait(&pool->barrier);
+  _processLevel(&workers[0]);
+  _barrierWait(&pool->barrier);
+}
+
+/* Terminar as threads do pool */
+static void _poolStop(struct _LevelPool* pool) {
+  pool->stop = 1;
+  _barrierWait(&pool->barrier);
+
+  for (unsigned int t = 1; t < pool->numThreads; t++) {
+    pthread_join(pool->threads[t], NULL);
+  }
+  pthread_cond_destroy(&pool->barrier.cond);
+  pthread_mutex_destroy(&pool->barrier.mutex);
+}
+#endif
+
+//
+// Computing the topological sorting, if any, using the 4th algorithm:
+// Kahn's algorithm, one level (wavefront) at a time: all the vertices of a
+// level are processed in parallel, decrementing the in-degrees of their
+// adjacents atomically, and those left without incoming edges form the next
+// level
+// The threads are started once, at the first level wide enough to be shared,
+// and meet at a barrier at the start and end of each such level
+// The resulting sequence lists the levels in order, and the vertices of each
+// level by increasing index, whatever the number of threads
+//
+GraphTopoSort* GraphTopoSortComputeV4(const Graph* g) {
+  assert(g != NULL && GraphIsDigraph(g) == 1);
+
+  // Create and initialize the struct
+
+  GraphTopoSort* topoSort = _create(g);
+  if (topoSort == NULL) return NULL;
+
+  unsigned int numVertices = topoSort->numVertices;
+
+  _Atomic unsigned int* inDegree = (_Atomic unsigned int*)malloc((numVertices + 1) * sizeof(_Atomic unsigned int));
+  topoSort->level = (unsigned int*)malloc((numVertices + 1) * sizeof(unsigned int));
+  topoSort->levelSizes = (unsigned int*)malloc((numVertices + 1) * sizeof(unsigned int));
+  if (inDegree == NULL || topoSort->level == NULL || topoSort->levelSizes == NULL) {
+    free(inDegree);
+    GraphTopoSortDestroy(&topoSort);
+    return NULL;
+  }
+
+  struct _LevelWork work;
+  work.graph = g;
+  work.inDegree = inDegree;
+  work.frontier = topoSort->vertexSequence;
+  work.level = topoSort->level;
+  atomic_init(&work.next, 0);
+  atomic_init(&work.tail, 0);
+
+  /* O nível 0 é formado pelos vértices com inDegree == 0 */
+  unsigned int tail = 0;
+  for (unsigned int i = 0; i < numVertices; i++) {
+
+    /* Incrementar o contador VERTEX_ITER */
+    InstrInc(VERTEX_ITER);
+
+    atomic_init(&inDegree[i], topoSort->numIncomingEdges[i]);
+    if (topoSort->numIncomingEdges[i] == 0) {
+      topoSort->level[i] = 0;
+      work.frontier[tail++] = i;
+    }
+  }
+
+  unsigned int maxThreads = _numThreads();
+  struct _LevelWorker workers[MAX_THREADS];
+  for (unsigned int t = 0; t < maxThreads; t++) {
+    workers[t].work = &work;
+    workers[t].pool = NULL;
+    workers[t].edgeIter = 0;
+  }
+
+#ifdef TOPO_POSIX
+  struct _LevelPool pool;
+  pool.numThreads = 0;
+#endif
+
+  /* Processar um nível de cada vez, até não haver mais vértices sem arestas incidentes */
+  unsigned int begin = 0;
+  while (begin < tail) {
+    topoSort->levelSizes[topoSort->numLevels] = tail - begin;
+
+    work.nextLevel = topoSort->numLevels + 1;
+    work.end = tail;
+    atomic_store(&work.next, begin);
+    atomic_store(&work.tail, tail);
+
+    /* Os níveis estreitos são processados só por esta thread */
+#ifdef TOPO_POSIX
+    if (tail - begin >= MIN_PARALLEL_LEVEL && maxThreads > 1) {
+      if (pool.numThreads == 0) {
+        topoSort->numThreads = _poolStart(&pool, workers, maxThreads);
+      }
+      _poolRunLevel(&pool, workers);
+    } else {
+      _processLevel(&workers[0]);
+    }
+#else
+    _processLevel(&workers[0]);
+#endif
+
+    topoSort->numLevels++;
+    begin = tail;
+    tail = atomic_load(&work.tail);
+  }
+
+#ifdef TOPO_POSIX
+  if (pool.numThreads > 0) {
+    _poolStop(&pool);
+  }
+#endif
+
+  unsigned long edgeIter = 0;
+  for (unsigned int t = 0; t < maxThreads; t++) {
+    edgeIter += workers[t].edgeIter;
+  }
+  InstrAdd(EDGE_ITER, edgeIter);
+  InstrAdd(EDGE_REM, edgeIter);
+
+  free(inDegree);
+
+  /* Verificar se o número de vértices adicionados é igual ao número de vértices do grafo */
+  if (tail == numVertices) {
+    topoSort->validResult = 1;
+
+    /* 
+      Reordenar a sequência (por contagem, pelo nível): cada nível fica com os seus vértices por ordem crescente,
+      o que não depende da ordem pela qual as threads os encontraram
+      numIncomingEdges já não é necessário, e guarda a próxima posição de cada nível
+    */
+    unsigned int* position = topoSort->numIncomingEdges;
+    unsigned int start = 0;
+    for (unsigned int l = 0; l < topoSort->numLevels; l++) {
+      position[l] = start;
+      start += topoSort->levelSizes[l];
+    }
+    for (unsigned int i = 0; i < numVertices; i++) {
+      topoSort->vertexSequence[position[topoSort->level[i]]++] = i;
+    }
+  }
+
+  return topoSort;
+}
+
+
+//
+// Computing the lexicographically smallest topological sorting, if any:
+// the 3rd algorithm, with a min-heap instead of the queue, so that the
+// smallest vertex without incoming edges is always the next one
+// O((V + E) log V), and the result does not depend on how the edges were
+// added
+//
+GraphTopoSort* GraphTopoSortComputeLex(const Graph* g) {
+  assert(g != NULL && GraphIsDigraph(g) == 1);
+
+  // Create and initialize the struct
+
+  GraphTopoSort* topoSort = _create(g);
+
+  unsigned int numVertices = GraphGetNumVertices(g);
+
+  /* Criar um heap e adicionar-lhe os vértices com inDegree == 0 */
+  Heap* h = HeapCreate(numVertices + 1);
+
+  for (unsigned int i = 0; i < numVertices; i++) {
+
+    /* Incrementar o contador VERTEX_ITER */
+    InstrInc(VERTEX_ITER);
+
+    if (topoSort->numIncomingEdges[i] == 0) {
+      HeapInsert(h, i);
+    }
+  }
+
+  unsigned int addedVertices = 0;
+
+  /* Repetir até o heap estar vazio, retirando sempre o menor vértice */
+  while (!HeapIsEmpty(h)) {
+
+    unsigned int v = HeapRemoveMin(h);
+
+    topoSort->vertexSequence[addedVertices] = v;
+    addedVertices++;
+
+    GraphAdjacents adj = GraphGetAdjacents(g, v);
+
+    for (unsigned int j = 0; j < adj.numAdjacents; j++) {
+
+      unsigned int w = adj.vertices[j];
+
+      /* Incrementar o contador EDGE_ITER */
+      InstrInc(EDGE_ITER);
+
+      /* Decrementar o número de arestas incidentes */
+      topoSort->numIncomingEdges[w]--;
+
+      /* Incrementar o contador EDGE_REM */
+      InstrInc(EDGE_REM);
+
+      if (topoSort->numIncomingEdges[w] == 0) {
+        HeapInsert(h, w);
+      }
+    }
+  }
+
+  /* Verificar se o número de vértices adicionados é igual ao número de vértices do grafo */
+  if (addedVertices == numVertices) {
+    topoSort->validResult = 1;
+  }
+
+  /* Destruir o heap */
+  HeapDestroy(&h);
+
+  return topoSort;
+}
+
 
 void GraphTopoSortDestroy(GraphTopoSort** p) {
   assert(*p != NULL);
@@ -372,6 +874,8 @@ void GraphTopoSortDestroy(GraphTopoSort** p) {
   free(aux->marked);
   free(aux->numIncomingEdges);
   free(aux->vertexSequence);
+  free(aux->level);
+  free(aux->levelSizes);
 
   free(*p);
   *p = NULL;
@@ -399,6 +903,33 @@ unsigned int* GraphTopoSortGetSequence(const GraphTopoSort* p) {
   return p->vertexSequence;
 }
 
+//
+// The level of each vertex, and the number of vertices in each level
+// Only computed by the 4th algorithm, for a valid sorting
+//
+const unsigned int* GraphTopoSortGetLevels(const GraphTopoSort* p) {
+  assert(p != NULL);
+  return p->validResult ? p->level : NULL;
+}
+
+unsigned int GraphTopoSortGetNumLevels(const GraphTopoSort* p) {
+  assert(p != NULL);
+  return (p->validResult && p->level != NULL) ? p->numLevels : 0;
+}
+
+const unsigned int* GraphTopoSortGetLevelSizes(const GraphTopoSort* p) {
+  assert(p != NULL);
+  return (p->validResult && p->level != NULL) ? p->levelSizes : NULL;
+}
+
+//
+// The largest number of threads used at the same time
+//
+unsigned int GraphTopoSortGetNumThreads(const GraphTopoSort* p) {
+  assert(p != NULL);
+  return p->numThreads;
+}
+
 // DISPLAYING on the console
 
 //
@@ -413,7 +944,7 @@ void GraphTopoSortDisplaySequence(const GraphTopoSort* p) {
   }
 
   printf("Topological Sorting - Vertex indices:\n");
-  for (unsigned int i = 0; i < GraphGetNumVertices(p->graph); i++) {
+  for (unsigned int i = 0; i < p->numVertices; i++) {
     printf("%d ", p->vertexSequence[i]);
   }
   printf("\n");
@@ -435,8 +966,12 @@ void GraphTopoSortDisplay(const GraphTopoSort* p) {
   }
 
   // The Digraph
-  for (unsigned int i = 0; i < GraphGetNumVertices(p->graph); i++) {
-    GraphListAdjacents(p->graph, p->vertexSequence[i]);
+  for (unsigned int i = 0; i < p->numVertices; i++) {
+    if (p->graph != NULL) {
+      GraphListAdjacents(p->graph, p->vertexSequence[i]);
+    } else {
+      GraphCSRListAdjacents(p->csr, p->vertexSequence[i]);
+    }
   }
   printf("\n");
 }
@@ -8,15 +8,41 @@
 #define _GRAPH_TOPOLOGICAL_SORTING_
 
 #include "Graph.h"
+#include "GraphCSR.h"
 #include "IntegersQueue.h"
 
 typedef struct _GraphTopoSort GraphTopoSort;
 
-GraphTopoSort* GraphTopoSortComputeV1(Graph* g);
+//
+// The graph is only read (V1 removes edges from a degree overlay, not from
+// the graph), so several sorts may run at the same time, in different
+// threads, over the same graph
+//
+
+GraphTopoSort* GraphTopoSortComputeV1(const Graph* g);
+
+GraphTopoSort* GraphTopoSortComputeV2(const Graph* g);
+
+GraphTopoSort* GraphTopoSortComputeV3(const Graph* g);
 
-GraphTopoSort* GraphTopoSortComputeV2(Graph* g);
+//
+// The 3rd algorithm, running over the CSR representation of a digraph
+//
+GraphTopoSort* GraphTopoSortComputeV3CSR(const GraphCSR* g);
+
+//
+// The 4th algorithm: Kahn's algorithm, one level at a time, with the
+// vertices of each level processed in parallel (by a pool of threads, one
+// per core, started at the first wide level and reused by the next ones)
+// The sequence lists the levels in order, each by increasing vertex index
+//
+GraphTopoSort* GraphTopoSortComputeV4(const Graph* g);
 
-GraphTopoSort* GraphTopoSortComputeV3(Graph* g);
+//
+// The lexicographically smallest topological sorting: of all the vertices
+// without (remaining) incoming edges, the smallest one is always chosen
+//
+GraphTopoSort* GraphTopoSortComputeLex(const Graph* g);
 
 void GraphTopoSortDestroy(GraphTopoSort** p);
 
@@ -26,6 +52,24 @@ int GraphTopoSortIsValid(const GraphTopoSort* p);
 
 unsigned int* GraphTopoSortGetSequence(const GraphTopoSort* p);
 
+//
+// Only for the 4th algorithm (NULL or 0 otherwise, or if no sorting exists):
+// the level of each vertex (0 if it has no incoming edges, otherwise 1 + the
+// largest level of its predecessors) and the number of vertices per level
+//
+const unsigned int* GraphTopoSortGetLevels(const GraphTopoSort* p);
+
+unsigned int GraphTopoSortGetNumLevels(const GraphTopoSort* p);
+
+const unsigned int* GraphTopoSortGetLevelSizes(const GraphTopoSort* p);
+
+//
+// The largest number of threads used at the same time (1 for all the
+// algorithms but the 4th one, for which it is the size of its pool, or 1 if
+// no level was wide enough to start it)
+//
+unsigned int GraphTopoSortGetNumThreads(const GraphTopoSort* p);
+
 // DISPLAYING on the console
 
 void GraphTopoSortDisplaySequence(const GraphTopoSort* p);
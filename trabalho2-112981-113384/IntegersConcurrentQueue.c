@@ -0,0 +1,309 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Bounded lock-free integers queues (First In First Out), for passing work
+// between threads
+
+#include "IntegersConcurrentQueue.h"
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define CONCURRENT_QUEUE_POSIX 1
+#include <sched.h>
+#endif
+
+// Size of a cache line, in bytes
+#define CACHE_LINE 64
+
+// Positions are counted from 0 and never wrap around (they are 64-bit):
+// position p is stored at index p & mask of the array
+
+struct _IntegersSPSCQueue {
+  size_t capacity;     // array size (a power of 2)
+  size_t mask;         // capacity - 1
+  unsigned int* data;  // the Queue data
+  char pad0[CACHE_LINE];
+  atomic_size_t head;  // next position to read (written by the consumer)
+  size_t cachedTail;   // last tail seen by the consumer
+  char pad1[CACHE_LINE];
+  atomic_size_t tail;  // next position to write (written by the producer)
+  size_t cachedHead;   // last head seen by the producer
+  char pad2[CACHE_LINE];
+};
+
+struct _Cell {
+  atomic_size_t sequence;  // position that may use the cell next (see below)
+  unsigned int value;
+};
+
+// A cell for position p is free for the producer of p when its sequence is p,
+// and holds the element of p, for its consumer, when its sequence is p + 1
+
+struct _IntegersMPMCQueue {
+  size_t capacity;       // array size (a power of 2)
+  size_t mask;           // capacity - 1
+  struct _Cell* cells;   // the Queue data
+  char pad0[CACHE_LINE];
+  atomic_size_t tail;    // next position to claim for writing
+  char pad1[CACHE_LINE];
+  atomic_size_t head;    // next position to claim for reading
+  char pad2[CACHE_LINE];
+};
+
+// PRIVATE auxiliary functions
+
+// The smallest power of 2 not below size (and not below 16)
+static size_t round_capacity(size_t size) {
+  size_t capacity = 16;
+  while (capacity < size) capacity *= 2;
+  return capacity;
+}
+
+// Let other threads run, while waiting for the queue
+static void wait_turn(void) {
+#ifdef CONCURRENT_QUEUE_POSIX
+  sched_yield();
+#endif
+}
+
+static size_t min_size(size_t a, size_t b) { return (a < b) ? a : b; }
+
+// PUBLIC functions: SPSC queue
+
+SPSCQueue* SPSCQueueCreate(size_t size) {
+  SPSCQueue* q = (SPSCQueue*)malloc(sizeof(SPSCQueue));
+  if (q == NULL) abort();
+
+  q->capacity = round_capacity(size);
+  q->mask = q->capacity - 1;
+  atomic_init(&q->head, 0);
+  atomic_init(&q->tail, 0);
+  q->cachedHead = 0;
+  q->cachedTail = 0;
+
+  q->data = (unsigned int*)malloc(q->capacity * sizeof(unsigned int));
+  if (q->data == NULL) {
+    free(q);
+    abort();
+  }
+  return q;
+}
+
+void SPSCQueueDestroy(SPSCQueue** p) {
+  assert(*p != NULL);
+  SPSCQueue* q = *p;
+  free(q->data);
+  free(q);
+  *p = NULL;
+}
+
+size_t SPSCQueueSize(const SPSCQueue* q) {
+  size_t head = atomic_load_explicit(&((SPSCQueue*)q)->head, memory_order_acquire);
+  size_t tail = atomic_load_explicit(&((SPSCQueue*)q)->tail, memory_order_acquire);
+  return (tail > head) ? tail - head : 0;
+}
+
+int SPSCQueueIsFull(const SPSCQueue* q) { return (SPSCQueueSize(q) == q->capacity) ? 1 : 0; }
+
+int SPSCQueueIsEmpty(const SPSCQueue* q) { return (SPSCQueueSize(q) == 0) ? 1 : 0; }
+
+// Producer side: number of free positions, from tail on
+static size_t spsc_free(SPSCQueue* q, size_t tail, size_t wanted) {
+  size_t free = q->capacity - (tail - q->cachedHead);
+  if (free < wanted) {
+    // Only read the consumer's position (and its cache line) when needed
+    q->cachedHead = atomic_load_explicit(&q->head, memory_order_acquire);
+    free = q->capacity - (tail - q->cachedHead);
+  }
+  return free;
+}
+
+// Consumer side: number of elements, from head on
+static size_t spsc_used(SPSCQueue* q, size_t head, size_t wanted) {
+  size_t used = q->cachedTail - head;
+  if (used < wanted) {
+    q->cachedTail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    used = q->cachedTail - head;
+  }
+  return used;
+}
+
+int SPSCQueueTryEnqueue(SPSCQueue* q, unsigned int i) {
+  size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  if (spsc_free(q, tail, 1) == 0) return 0;
+
+  q->data[tail & q->mask] = i;
+  atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+  return 1;
+}
+
+int SPSCQueueTryDequeue(SPSCQueue* q, unsigned int* i) {
+  size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+  if (spsc_used(q, head, 1) == 0) return 0;
+
+  *i = q->data[head & q->mask];
+  atomic_store_explicit(&q->head, head + 1, memory_order_release);
+  return 1;
+}
+
+void SPSCQueueEnqueue(SPSCQueue* q, unsigned int i) {
+  while (!SPSCQueueTryEnqueue(q, i)) wait_turn();
+}
+
+unsigned int SPSCQueueDequeue(SPSCQueue* q) {
+  unsigned int i;
+  while (!SPSCQueueTryDequeue(q, &i)) wait_turn();
+  return i;
+}
+
+size_t SPSCQueueEnqueueBatch(SPSCQueue* q, const unsigned int* items, size_t count) {
+  size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  count = min_size(count, spsc_free(q, tail, count));
+
+  // At most two copies: up to the end of the array, and then from its start
+  size_t index = tail & q->mask;
+  size_t first = min_size(count, q->capacity - index);
+  memcpy(&q->data[index], items, first * sizeof(unsigned int));
+  memcpy(q->data, &items[first], (count - first) * sizeof(unsigned int));
+
+  // A single release publishes the whole batch
+  atomic_store_explicit(&q->tail, tail + count, memory_order_release);
+  return count;
+}
+
+size_t SPSCQueueDequeueBatch(SPSCQueue* q, unsigned int* items, size_t count) {
+  size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+  count = min_size(count, spsc_used(q, head, count));
+
+  size_t index = head & q->mask;
+  size_t first = min_size(count, q->capacity - index);
+  memcpy(items, &q->data[index], first * sizeof(unsigned int));
+  memcpy(&items[first], q->data, (count - first) * sizeof(unsigned int));
+
+  atomic_store_explicit(&q->head, head + count, memory_order_release);
+  return count;
+}
+
+// PUBLIC functions: MPMC queue
+
+MPMCQueue* MPMCQueueCreate(size_t size) {
+  MPMCQueue* q = (MPMCQueue*)malloc(sizeof(MPMCQueue));
+  if (q == NULL) abort();
+
+  q->capacity = round_capacity(size);
+  q->mask = q->capacity - 1;
+  atomic_init(&q->head, 0);
+  atomic_init(&q->tail, 0);
+
+  q->cells = (struct _Cell*)malloc(q->capacity * sizeof(struct _Cell));
+  if (q->cells == NULL) {
+    free(q);
+    abort();
+  }
+  for (size_t p = 0; p < q->capacity; p++) {
+    atomic_init(&q->cells[p].sequence, p);
+  }
+  return q;
+}
+
+void MPMCQueueDestroy(MPMCQueue** p) {
+  assert(*p != NULL);
+  MPMCQueue* q = *p;
+  free(q->cells);
+  free(q);
+  *p = NULL;
+}
+
+size_t MPMCQueueSize(const MPMCQueue* q) {
+  size_t head = atomic_load_explicit(&((MPMCQueue*)q)->head, memory_order_acquire);
+  size_t tail = atomic_load_explicit(&((MPMCQueue*)q)->tail, memory_order_acquire);
+  return (tail > head) ? min_size(tail - head, q->capacity) : 0;
+}
+
+int MPMCQueueIsFull(const MPMCQueue* q) { return (MPMCQueueSize(q) == q->capacity) ? 1 : 0; }
+
+int MPMCQueueIsEmpty(const MPMCQueue* q) { return (MPMCQueueSize(q) == 0) ? 1 : 0; }
+
+// Number of consecutive cells, from position p on (up to count), whose
+// sequence is their position plus offset: 0 for the producers, 1 for the
+// consumers
+static size_t mpmc_ready(MPMCQueue* q, size_t p, size_t count, size_t offset) {
+  size_t k = 0;
+  while (k < count) {
+    size_t sequence = atomic_load_explicit(&q->cells[(p + k) & q->mask].sequence, memory_order_acquire);
+    if (sequence != p + k + offset) break;
+    k++;
+  }
+  return k;
+}
+
+// Claims up to count consecutive positions of *position, whose cells are
+// ready, returning the first one in *first and how many were claimed
+// If position moves before the claim, another thread got there first: retry
+static size_t mpmc_claim(MPMCQueue* q, atomic_size_t* position, size_t count, size_t offset,
+                         size_t* first) {
+  size_t p = atomic_load_explicit(position, memory_order_relaxed);
+  for (;;) {
+    size_t k = mpmc_ready(q, p, count, offset);
+    if (k == 0) {
+      // Full (or empty) unless another thread has already moved on
+      size_t now = atomic_load_explicit(position, memory_order_relaxed);
+      if (now == p) return 0;
+      p = now;
+      continue;
+    }
+    if (atomic_compare_exchange_weak_explicit(position, &p, p + k, memory_order_relaxed,
+                                              memory_order_relaxed)) {
+      *first = p;
+      return k;
+    }
+  }
+}
+
+int MPMCQueueTryEnqueue(MPMCQueue* q, unsigned int i) {
+  return (MPMCQueueEnqueueBatch(q, &i, 1) == 1) ? 1 : 0;
+}
+
+int MPMCQueueTryDequeue(MPMCQueue* q, unsigned int* i) {
+  return (MPMCQueueDequeueBatch(q, i, 1) == 1) ? 1 : 0;
+}
+
+void MPMCQueueEnqueue(MPMCQueue* q, unsigned int i) {
+  while (!MPMCQueueTryEnqueue(q, i)) wait_turn();
+}
+
+unsigned int MPMCQueueDequeue(MPMCQueue* q) {
+  unsigned int i;
+  while (!MPMCQueueTryDequeue(q, &i)) wait_turn();
+  return i;
+}
+
+size_t MPMCQueueEnqueueBatch(MPMCQueue* q, const unsigned int* items, size_t count) {
+  size_t first;
+  count = mpmc_claim(q, &q->tail, min_size(count, q->capacity), 0, &first);
+
+  for (size_t k = 0; k < count; k++) {
+    struct _Cell* cell = &q->cells[(first + k) & q->mask];
+    cell->value = items[k];
+    atomic_store_explicit(&cell->sequence, first + k + 1, memory_order_release);
+  }
+  return count;
+}
+
+size_t MPMCQueueDequeueBatch(MPMCQueue* q, unsigned int* items, size_t count) {
+  size_t first;
+  count = mpmc_claim(q, &q->head, min_size(count, q->capacity), 1, &first);
+
+  // Each cell is freed for the producer of the same index, one lap later
+  for (size_t k = 0; k < count; k++) {
+    struct _Cell* cell = &q->cells[(first + k) & q->mask];
+    items[k] = cell->value;
+    atomic_store_explicit(&cell->sequence, first + k + q->capacity, memory_order_release);
+  }
+  return count;
+}
@@ -0,0 +1,86 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Bounded lock-free integers queues (First In First Out), for passing work
+// between threads
+//
+// Both are circular arrays with a power-of-two capacity, fixed at creation:
+//   SPSCQueue - one producer thread and one consumer thread
+//   MPMCQueue - any number of producer and consumer threads
+//
+// The positions written by producers and read by consumers sit on separate
+// cache lines, so that the two sides do not invalidate each other's caches.
+//
+// The Try functions return 1 on success and 0 if the queue is full (enqueue)
+// or empty (dequeue); the others wait (yielding the processor) until they
+// succeed. The batch functions move as many elements as they can, up to
+// count, and return how many they moved.
+//
+// Size, IsEmpty and IsFull are only exact when no other thread is using the
+// queue.
+//
+
+#ifndef _INTEGERS_CONCURRENT_QUEUE_
+#define _INTEGERS_CONCURRENT_QUEUE_
+
+#include <stddef.h>
+
+// Single producer, single consumer
+
+typedef struct _IntegersSPSCQueue SPSCQueue;
+
+SPSCQueue* SPSCQueueCreate(size_t size);
+
+void SPSCQueueDestroy(SPSCQueue** p);
+
+size_t SPSCQueueSize(const SPSCQueue* q);
+
+int SPSCQueueIsFull(const SPSCQueue* q);
+
+int SPSCQueueIsEmpty(const SPSCQueue* q);
+
+int SPSCQueueTryEnqueue(SPSCQueue* q, unsigned int i);
+
+int SPSCQueueTryDequeue(SPSCQueue* q, unsigned int* i);
+
+void SPSCQueueEnqueue(SPSCQueue* q, unsigned int i);
+
+unsigned int SPSCQueueDequeue(SPSCQueue* q);
+
+size_t SPSCQueueEnqueueBatch(SPSCQueue* q, const unsigned int* items,
+                             size_t count);
+
+size_t SPSCQueueDequeueBatch(SPSCQueue* q, unsigned int* items, size_t count);
+
+// Multiple producers, multiple consumers
+
+typedef struct _IntegersMPMCQueue MPMCQueue;
+
+MPMCQueue* MPMCQueueCreate(size_t size);
+
+void MPMCQueueDestroy(MPMCQueue** p);
+
+size_t MPMCQueueSize(const MPMCQueue* q);
+
+int MPMCQueueIsFull(const MPMCQueue* q);
+
+int MPMCQueueIsEmpty(const MPMCQueue* q);
+
+int MPMCQueueTryEnqueue(MPMCQueue* q, unsigned int i);
+
+int MPMCQueueTryDequeue(MPMCQueue* q, unsigned int* i);
+
+void MPMCQueueEnqueue(MPMCQueue* q, unsigned int i);
+
+unsigned int MPMCQueueDequeue(MPMCQueue* q);
+
+//
+// The elements of a batch take consecutive positions of the queue: they are
+// not interleaved with those of other threads
+//
+size_t MPMCQueueEnqueueBatch(MPMCQueue* q, const unsigned int* items,
+                             size_t count);
+
+size_t MPMCQueueDequeueBatch(MPMCQueue* q, unsigned int* items, size_t count);
+
+#endif  // _INTEGERS_CONCURRENT_QUEUE_
@@ -0,0 +1,98 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Integers min-heap (smallest first) implementation based on an array
+
+#include "IntegersHeap.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+// Number of children of each node
+#define ARITY 4
+
+struct _IntegersHeap {
+  unsigned int max_size;  // maximum Heap size
+  unsigned int cur_size;  // current Heap size
+  unsigned int* data;     // the Heap data: data[0] is the smallest element
+};
+
+// PUBLIC functions
+
+Heap* HeapCreate(unsigned int size) {
+  assert(size >= 1);
+  Heap* h = (Heap*)malloc(sizeof(Heap));
+  if (h == NULL) abort();
+
+  h->max_size = size;
+  h->cur_size = 0;
+
+  h->data = (unsigned int*)malloc(size * sizeof(unsigned int));
+  if (h->data == NULL) {
+    free(h);
+    abort();
+  }
+  return h;
+}
+
+void HeapDestroy(Heap** p) {
+  assert(*p != NULL);
+  Heap* h = *p;
+  free(h->data);
+  free(h);
+  *p = NULL;
+}
+
+void HeapClear(Heap* h) { h->cur_size = 0; }
+
+unsigned int HeapSize(const Heap* h) { return h->cur_size; }
+
+int HeapIsFull(const Heap* h) { return (h->cur_size == h->max_size) ? 1 : 0; }
+
+int HeapIsEmpty(const Heap* h) { return (h->cur_size == 0) ? 1 : 0; }
+
+unsigned int HeapPeek(const Heap* h) {
+  assert(h->cur_size > 0);
+  return h->data[0];
+}
+
+void HeapInsert(Heap* h, unsigned int i) {
+  assert(h->cur_size < h->max_size);
+
+  // Move the larger parents down, until the place of i is found
+  unsigned int pos = h->cur_size++;
+  while (pos > 0) {
+    unsigned int parent = (pos - 1) / ARITY;
+    if (h->data[parent] <= i) break;
+    h->data[pos] = h->data[parent];
+    pos = parent;
+  }
+  h->data[pos] = i;
+}
+
+unsigned int HeapRemoveMin(Heap* h) {
+  assert(h->cur_size > 0);
+
+  unsigned int min = h->data[0];
+  unsigned int last = h->data[--h->cur_size];
+
+  // Move the smallest children up, until the place of the last element is found
+  unsigned int pos = 0;
+  for (;;) {
+    unsigned int first = ARITY * pos + 1;
+    if (first >= h->cur_size) break;
+
+    unsigned int end = (first + ARITY < h->cur_size) ? first + ARITY : h->cur_size;
+    unsigned int child = first;
+    for (unsigned int c = first + 1; c < end; c++) {
+      if (h->data[c] < h->data[child]) child = c;
+    }
+
+    if (h->data[child] >= last) break;
+    h->data[pos] = h->data[child];
+    pos = child;
+  }
+  h->data[pos] = last;
+
+  return min;
+}
@@ -0,0 +1,40 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// Integers min-heap (smallest first) implementation based on an array
+//
+// The heap is 4-ary: the children of position i are 4i+1, ..., 4i+4, which
+// sit next to each other in memory, so that each level down touches a single
+// cache line and the heap is half as deep as a binary one.
+//
+
+#ifndef _INTEGERS_HEAP_
+#define _INTEGERS_HEAP_
+
+typedef struct _IntegersHeap Heap;
+
+Heap* HeapCreate(unsigned int size);
+
+void HeapDestroy(Heap** p);
+
+void HeapClear(Heap* h);
+
+unsigned int HeapSize(const Heap* h);
+
+int HeapIsFull(const Heap* h);
+
+int HeapIsEmpty(const Heap* h);
+
+//
+// The smallest element
+//
+unsigned int HeapPeek(const Heap* h);
+
+void HeapInsert(Heap* h, unsigned int i);
+
+//
+// Removes and returns the smallest element
+//
+unsigned int HeapRemoveMin(Heap* h);
+
+#endif  // _INTEGERS_HEAP_
@@ -9,36 +9,59 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include "instrumentation.h"
 
 struct _IntegersQueue {
-  int max_size;  // maximum Queue size
-  int cur_size;  // current Queue size
-  int head;
-  int tail;
-  int* data;  // the Queue data (integers stored in an array)
+  size_t capacity;     // current array size (a power of 2)
+  size_t mask;         // capacity - 1
+  size_t cur_size;     // current Queue size
+  size_t head;         // position of the first element
+  unsigned int* data;  // the Queue data (integers stored in an array)
 };
 
-// PRIVATE auxiliary function
+// PRIVATE auxiliary functions
 
-static int increment_index(const Queue* q, int i) {
-  return (i + 1 < q->max_size) ? i + 1 : 0;
+// The smallest power of 2 not below size (and not below 16)
+static size_t round_capacity(size_t size) {
+  size_t capacity = 16;
+  while (capacity < size) capacity *= 2;
+  return capacity;
+}
+
+// Make room for, at least, size elements, keeping them in order
+static void reserve(Queue* q, size_t size) {
+  if (size <= q->capacity) return;
+
+  size_t capacity = round_capacity(size);
+  unsigned int* data = (unsigned int*)malloc(capacity * sizeof(unsigned int));
+  if (data == NULL) abort();
+
+  // The elements go to positions 0 .. cur_size - 1 of the new array
+  size_t first = q->capacity - q->head;  // elements before the wrap-around
+  if (first > q->cur_size) first = q->cur_size;
+  memcpy(data, &q->data[q->head], first * sizeof(unsigned int));
+  memcpy(&data[first], q->data, (q->cur_size - first) * sizeof(unsigned int));
+
+  free(q->data);
+  q->data = data;
+  q->capacity = capacity;
+  q->mask = capacity - 1;
+  q->head = 0;
 }
 
 // PUBLIC functions
 
-Queue* QueueCreate(int size) {
-  assert(size >= 1 && size <= 1000000);
+Queue* QueueCreate(size_t size) {
   Queue* q = (Queue*)malloc(sizeof(Queue));
   if (q == NULL) abort();
 
-  q->max_size = size;
+  q->capacity = round_capacity(size);
+  q->mask = q->capacity - 1;
   q->cur_size = 0;
+  q->head = 0;
 
-  q->head = 1;  // cur_size = tail - head + 1
-  q->tail = 0;
-
-  q->data = (int*)malloc(size * sizeof(int));
+  q->data = (unsigned int*)malloc(q->capacity * sizeof(unsigned int));
   if (q->data == NULL) {
     free(q);
     abort();
@@ -56,32 +79,56 @@ void QueueDestroy(Queue** p) {
 
 void QueueClear(Queue* q) {
   q->cur_size = 0;
-  q->head = 1;  // cur_size = tail - head + 1
-  q->tail = 0;
+  q->head = 0;
 }
 
-int QueueSize(const Queue* q) { return q->cur_size; }
+size_t QueueSize(const Queue* q) { return q->cur_size; }
 
-int QueueIsFull(const Queue* q) { return (q->cur_size == q->max_size) ? 1 : 0; }
+int QueueIsFull(const Queue* q) { return (q->cur_size == q->capacity) ? 1 : 0; }
 
 int QueueIsEmpty(const Queue* q) { return (q->cur_size == 0) ? 1 : 0; }
 
-int QueuePeek(const Queue* q) {
+unsigned int QueuePeek(const Queue* q) {
   assert(q->cur_size > 0);
   return q->data[q->head];
 }
 
-void QueueEnqueue(Queue* q, int i) {
-  assert(q->cur_size < q->max_size);
-  q->tail = increment_index(q, q->tail);
-  q->data[q->tail] = i;
+void QueueEnqueue(Queue* q, unsigned int i) {
+  if (q->cur_size == q->capacity) reserve(q, q->capacity + 1);
+  q->data[(q->head + q->cur_size) & q->mask] = i;
   q->cur_size++;
 }
 
-int QueueDequeue(Queue* q) {
+unsigned int QueueDequeue(Queue* q) {
   assert(q->cur_size > 0);
-  int old_head = q->head;
-  q->head = increment_index(q, q->head);
+  unsigned int i = q->data[q->head];
+  q->head = (q->head + 1) & q->mask;
   q->cur_size--;
-  return q->data[old_head];
+  return i;
+}
+
+void QueueEnqueueSpan(Queue* q, const unsigned int* items, size_t count) {
+  reserve(q, q->cur_size + count);
+
+  // At most two copies: up to the end of the array, and then from its start
+  size_t tail = (q->head + q->cur_size) & q->mask;
+  size_t first = q->capacity - tail;
+  if (first > count) first = count;
+  memcpy(&q->data[tail], items, first * sizeof(unsigned int));
+  memcpy(q->data, &items[first], (count - first) * sizeof(unsigned int));
+
+  q->cur_size += count;
+}
+
+size_t QueueDequeueSpan(Queue* q, unsigned int* items, size_t maxCount) {
+  size_t count = (maxCount < q->cur_size) ? maxCount : q->cur_size;
+
+  size_t first = q->capacity - q->head;
+  if (first > count) first = count;
+  memcpy(items, &q->data[q->head], first * sizeof(unsigned int));
+  memcpy(&items[first], q->data, (count - first) * sizeof(unsigned int));
+
+  q->head = (q->head + count) & q->mask;
+  q->cur_size -= count;
+  return count;
 }
@@ -5,28 +5,51 @@
 //
 // Integers queue (First In First Out) implementation based on a circular array
 //
+// The array has a power-of-two capacity, so that indices wrap around with a
+// mask, and doubles whenever an element is added to a full queue.
+//
 
 #ifndef _INTEGERS_QUEUE_
 #define _INTEGERS_QUEUE_
 
+#include <stddef.h>
+
 typedef struct _IntegersQueue Queue;
 
-Queue* QueueCreate(int size);
+//
+// size is the initial capacity (it may be 0)
+//
+Queue* QueueCreate(size_t size);
 
 void QueueDestroy(Queue** p);
 
 void QueueClear(Queue* q);
 
-int QueueSize(const Queue* q);
+size_t QueueSize(const Queue* q);
 
+//
+// Full means that the next enqueue makes the queue grow
+//
 int QueueIsFull(const Queue* q);
 
 int QueueIsEmpty(const Queue* q);
 
-int QueuePeek(const Queue* q);
+unsigned int QueuePeek(const Queue* q);
+
+void QueueEnqueue(Queue* q, unsigned int i);
 
-void QueueEnqueue(Queue* q, int i);
+unsigned int QueueDequeue(Queue* q);
 
-int QueueDequeue(Queue* q);
+// Bulk operations, on spans of consecutive elements
+
+//
+// Enqueues items[0], ..., items[count - 1], in this order
+//
+void QueueEnqueueSpan(Queue* q, const unsigned int* items, size_t count);
+
+//
+// Dequeues up to maxCount elements into items, returning how many there were
+//
+size_t QueueDequeueSpan(Queue* q, unsigned int* items, size_t maxCount);
 
 #endif  // _INTEGERS_QUEUE_
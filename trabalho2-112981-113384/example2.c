@@ -7,6 +7,7 @@
 //
 
 #include "Graph.h"
+#include "GraphCriticalPath.h"
 #include "GraphTopologicalSorting.h"
 
 int main(void) {
@@ -91,9 +92,37 @@ int main(void) {
 
   GraphTopoSortDestroy(&result03);
 
+  // A WEIGHTED DAG: the weight of (v, w) is the time v takes before w can start
+
+  Graph* g03 = GraphCreate(6, 1, 1);
+
+  GraphAddWeightedEdge(g03, 0, 1, 3.0);
+  GraphAddWeightedEdge(g03, 0, 2, 2.0);
+  GraphAddWeightedEdge(g03, 1, 3, 4.0);
+  GraphAddWeightedEdge(g03, 2, 3, 1.0);
+  GraphAddWeightedEdge(g03, 2, 4, 5.0);
+  GraphAddWeightedEdge(g03, 3, 5, 2.0);
+  GraphAddWeightedEdge(g03, 4, 5, 1.0);
+
+  GraphDisplay(g03);
+
+  // CRITICAL PATH, over the order of the 3rd algorithm
+
+  printf(" *** Critical Path ***\n");
+
+  result03 = GraphTopoSortComputeV3(g03);
+
+  GraphCriticalPath* critical = GraphCriticalPathCompute(g03, result03);
+
+  GraphCriticalPathDisplay(critical);
+
+  GraphCriticalPathDestroy(&critical);
+  GraphTopoSortDestroy(&result03);
+
   // House-keeping
   GraphDestroy(&g01);
   GraphDestroy(&g02);
+  GraphDestroy(&g03);
 
   return 0;
 }
@@ -6,37 +6,110 @@
 // TOPOLOGICAL SORTING
 //
 // ./example3 GRAPH_FILE ...
-//     Will load each GRAPH_FILE and run the 3 sort algorithms on it
+//     Will load each GRAPH_FILE and run the 4 sort algorithms on it, and the
+//     one that gives the lexicographically smallest sorting
+//     (and the 3rd one again, over the CSR representation read from the same
+//     file, checking that it gives the same sorting)
+//     The graph is also saved as a binary snapshot, which is loaded back and
+//     compared with that CSR representation
+//     If it has cycles, one of them is also shown; otherwise, its vertices
+//     are run as tasks by the DAG executor
+//
+// With the environment variable INSTR_HW set, the hardware counters (cycles,
+// cache misses, ...) are also shown, where available
+// With INSTR_TRACE=FILE, the time taken by each step is written to FILE, as
+// a Chrome trace (for chrome://tracing or https://ui.perfetto.dev)
+// With INSTR_FORMAT=csv or INSTR_FORMAT=json, only the measurements are
+// written, one CSV or JSON record per algorithm and file
 //
 
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "Graph.h"
+#include "GraphCSR.h"
+#include "GraphDAGExecutor.h"
+#include "GraphSCC.h"
 #include "GraphTopologicalSorting.h"
 #include "instrumentation.h"
 
-typedef GraphTopoSort* (*TopoSortFcn)(Graph*);
+typedef GraphTopoSort* (*TopoSortFcn)(const Graph*);
 
 // Number of different versions of topological sort algorithm
-#define VERSIONS 3
+#define VERSIONS 5
 
 // Pointers to Topological Sort Functions
 TopoSortFcn topoSortFcns[VERSIONS] = {
   GraphTopoSortComputeV1,
   GraphTopoSortComputeV2,
-  GraphTopoSortComputeV3
+  GraphTopoSortComputeV3,
+  GraphTopoSortComputeV4,
+  GraphTopoSortComputeLex
 };
 
 // Names of Topological Sort Functions
 char *topoSortNames[VERSIONS] = {
   "TopoSortV1",
   "TopoSortV2",
-  "TopoSortV3"
+  "TopoSortV3",
+  "TopoSortV4",
+  "TopoSortLex"
 };
 
 
+// Whether the sortings and other results are shown (not with CSV or JSON)
+static int showResults = 1;
+
+// Temporary file for the binary snapshot of each graph
+#define SNAPSHOT_FILE "example3.snapshot"
+
+
+// Whether two sorts found the same topological sorting (or both found none)
+static int sameSorting(const GraphTopoSort* a, const GraphTopoSort* b,
+                       unsigned int numVertices) {
+  if (GraphTopoSortIsValid(a) != GraphTopoSortIsValid(b)) return 0;
+  if (!GraphTopoSortIsValid(a)) return 1;
+  return memcmp(GraphTopoSortGetSequence(a), GraphTopoSortGetSequence(b),
+                numVertices * sizeof(unsigned int)) == 0;
+}
+
+
+// Whether two CSR representations hold the same graph
+static int sameCSR(const GraphCSR* a, const GraphCSR* b) {
+  unsigned int numVertices = GraphCSRGetNumVertices(a);
+  if (GraphCSRIsDigraph(a) != GraphCSRIsDigraph(b) ||
+      GraphCSRIsWeighted(a) != GraphCSRIsWeighted(b) ||
+      GraphCSRGetNumVertices(b) != numVertices ||
+      GraphCSRGetNumEdges(a) != GraphCSRGetNumEdges(b)) {
+    return 0;
+  }
+  for (unsigned int v = 0; v < numVertices; v++) {
+    GraphAdjacents adjA = GraphCSRGetAdjacents(a, v);
+    GraphAdjacents adjB = GraphCSRGetAdjacents(b, v);
+    if (adjA.numAdjacents != adjB.numAdjacents ||
+        GraphCSRGetVertexInDegree(a, v) != GraphCSRGetVertexInDegree(b, v)) {
+      return 0;
+    }
+    for (unsigned int j = 0; j < adjA.numAdjacents; j++) {
+      if (adjA.vertices[j] != adjB.vertices[j] ||
+          (adjA.weights != NULL && adjA.weights[j] != adjB.weights[j])) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+
+// The task run for each vertex by the DAG executor
+static void emptyTask(unsigned int v, void* arg) {
+  (void)v;
+  (void)arg;
+}
+
+
 // Load graph from file and apply all sort algorithms in turn
 void doSortsGraphFile(char *fname) {
 
@@ -47,38 +120,174 @@ void doSortsGraphFile(char *fname) {
     exit(2);
   }
 
-  Graph* originalG = GraphFromFile(f);
+  Graph* originalG;
+  INSTR_REGION("GraphFromFile") {
+    originalG = GraphFromFile(f);
+  }
   
   fclose(f);
+
+  if (originalG == NULL) {
+    exit(2);
+  }
   
   assert(GraphIsDigraph(originalG));
 
   // Uncomment for debugging
   // GraphDisplay(originalG);
 
+  // Identification of the records written by InstrPrint in CSV or JSON
+  InstrSetLabel("graph", fname);
+  InstrSetLabelNumber("vertices", GraphGetNumVertices(originalG));
+  InstrSetLabelNumber("edges", GraphGetNumEdges(originalG));
+
   // TOPOLOGICAL SORTING
 
+  // The result of the 3rd algorithm is kept, to compare with its CSR version
+  GraphTopoSort* resultV3 = NULL;
+
   for (int v = 0; v < VERSIONS; v++) {
     TopoSortFcn sortFcn = topoSortFcns[v];
     char* sortName = topoSortNames[v];
 
-    // Make a copy of the original graph
-    Graph *g = GraphCopy(originalG);
-  
-    printf("FILE: %s\n", fname);
-    printf("SORT: %s\n", sortName);
+    // The sorts only read the graph: no copy is needed
+    if (showResults) {
+      printf("FILE: %s\n", fname);
+      printf("SORT: %s\n", sortName);
+    }
     
     InstrReset();
-    GraphTopoSort* result = sortFcn(g);
+    GraphTopoSort* result;
+    INSTR_REGION(sortName) {
+      result = sortFcn(originalG);
+    }
+    InstrSetLabel("algorithm", sortName);
+    InstrSetLabelNumber("threads", GraphTopoSortGetNumThreads(result));
     InstrPrint();
 
+    if (showResults) {
+      printf("RESULT: ");
+      GraphTopoSortDisplaySequence(result);
+      printf("--------\n");
+    }
+
+    if (sortFcn == GraphTopoSortComputeV3) {
+      resultV3 = result;
+    } else {
+      GraphTopoSortDestroy(&result);
+    }
+  }
+
+  // The 3rd algorithm, over the CSR representation built directly from the file
+  f = fopen(fname, "r");
+  if (f == NULL) {
+    perror("fopen");
+    exit(2);
+  }
+
+  GraphCSR* csr;
+  INSTR_REGION("GraphCSRFromFile") {
+    csr = GraphCSRFromFile(f);
+  }
+
+  fclose(f);
+
+  if (csr == NULL) {
+    exit(2);
+  }
+
+  if (showResults) {
+    printf("FILE: %s\n", fname);
+    printf("SORT: %s\n", "TopoSortV3CSR");
+  }
+
+  InstrReset();
+  GraphTopoSort* result;
+  INSTR_REGION("TopoSortV3CSR") {
+    result = GraphTopoSortComputeV3CSR(csr);
+  }
+  InstrSetLabel("algorithm", "TopoSortV3CSR");
+  InstrSetLabelNumber("threads", 1);
+  InstrPrint();
+
+  if (showResults) {
     printf("RESULT: ");
     GraphTopoSortDisplaySequence(result);
     printf("--------\n");
+  }
 
-    GraphTopoSortDestroy(&result);
-    GraphDestroy(&g);
+  // Both representations hold the same digraph: the sortings must be equal
+  if (!sameSorting(resultV3, result, GraphGetNumVertices(originalG))) {
+    fprintf(stderr, "%s: TopoSortV3CSR differs from TopoSortV3\n", fname);
+    exit(4);
   }
+
+  GraphTopoSortDestroy(&resultV3);
+  GraphTopoSortDestroy(&result);
+
+  // Save the digraph as a binary snapshot, load it back and compare
+  int saved;
+  INSTR_REGION("GraphSave") {
+    saved = GraphSave(originalG, SNAPSHOT_FILE);
+  }
+
+  GraphCSR* snapshot = NULL;
+  if (saved) {
+    INSTR_REGION("GraphLoadSnapshot") {
+      snapshot = GraphLoadSnapshot(SNAPSHOT_FILE, 1);
+    }
+  }
+
+  remove(SNAPSHOT_FILE);
+
+  if (snapshot == NULL || !sameCSR(csr, snapshot)) {
+    fprintf(stderr, "%s: the snapshot does not hold the same graph\n", fname);
+    exit(4);
+  }
+
+  GraphCSRDestroy(&snapshot);
+  GraphCSRDestroy(&csr);
+
+  // When there is no topological sorting, show a cycle that prevents it
+  GraphSCC* scc;
+  INSTR_REGION("GraphSCCCompute") {
+    scc = GraphSCCCompute(originalG);
+  }
+
+  if (!GraphSCCIsAcyclic(scc)) {
+    if (!showResults) {
+      GraphSCCDestroy(&scc);
+      GraphDestroy(&originalG);
+      return;
+    }
+    printf("FILE: %s\n", fname);
+    printf("Strongly connected components = %u\n", GraphSCCGetNumComponents(scc));
+    GraphSCCDisplayCycle(scc);
+    printf("--------\n");
+  } else {
+    // Otherwise, run every vertex as an (empty) task, on all cores
+    GraphDAGExecutorStats stats;
+
+    if (showResults) {
+      printf("FILE: %s\n", fname);
+      printf("EXECUTE: %s\n", "DAGExecutor");
+    }
+
+    InstrReset();
+    INSTR_REGION("DAGExecutor") {
+      GraphDAGExecute(originalG, emptyTask, NULL, 0, &stats);
+    }
+    InstrSetLabel("algorithm", "DAGExecutor");
+    InstrSetLabelNumber("threads", stats.numThreads);
+    InstrPrint();
+
+    if (showResults) {
+      GraphDAGExecutorStatsDisplay(&stats);
+      printf("--------\n");
+    }
+  }
+
+  GraphSCCDestroy(&scc);
   
   // House-keeping
   GraphDestroy(&originalG);
@@ -93,13 +302,35 @@ int main(int argc, char *argv[]) {
   }
 
   InstrCalibrate();
+  if (getenv("INSTR_HW") != NULL && InstrHWEnable() == 0) {
+    fprintf(stderr, "%s: hardware counters not available\n", argv[0]);
+  }
   InstrName[0] = "vertex_access";
   InstrName[1] = "edge_access";
   InstrName[2] = "edgeRemoved";
+  InstrName[3] = "steals";       // Only counted by the DAG executor
+  InstrName[4] = "idle_ns";
+  InstrName[5] = "tasks_per_s";
+
+  char* format = getenv("INSTR_FORMAT");
+  if (format != NULL && strcmp(format, "csv") == 0) {
+    InstrSetFormat(INSTR_CSV);
+    showResults = 0;
+  } else if (format != NULL && strcmp(format, "json") == 0) {
+    InstrSetFormat(INSTR_JSON);
+    showResults = 0;
+  }
 
   for (int i = 1; i < argc; i++) {
     char *fname = argv[i];
-    doSortsGraphFile(fname);
+    INSTR_REGION(fname) {
+      doSortsGraphFile(fname);
+    }
+  }
+
+  char* traceFile = getenv("INSTR_TRACE");
+  if (traceFile != NULL && InstrRegionsWriteTrace(traceFile) != 0) {
+    exit(3);
   }
 
   return 0;
@@ -0,0 +1,56 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// DYNAMIC TOPOLOGICAL ORDER EXAMPLE
+//
+
+#include <stdio.h>
+
+#include "Graph.h"
+#include "GraphDynTopoOrder.h"
+
+static void addEdge(GraphDynTopoOrder* order, unsigned int v, unsigned int w) {
+  int result = GraphDynTopoOrderAddEdge(order, v, w);
+
+  printf("Add %u -> %u: %s\n", v, w,
+         result == 1 ? "added" : (result == 0 ? "already exists" : "REJECTED (cycle)"));
+  GraphDynTopoOrderDisplaySequence(order);
+}
+
+int main(void) {
+  // The DIGRAPH
+  Graph* g01 = GraphCreate(7, 1, 0);
+
+  GraphAddEdge(g01, 0, 1);
+  GraphAddEdge(g01, 1, 2);
+  GraphAddEdge(g01, 3, 4);
+  GraphAddEdge(g01, 4, 5);
+
+  GraphDisplay(g01);
+
+  // The initial order
+  GraphDynTopoOrder* order = GraphDynTopoOrderCreate(g01);
+
+  GraphDynTopoOrderDisplaySequence(order);
+
+  // Edges added afterwards: only the affected vertices are reordered
+  addEdge(order, 5, 0);
+  addEdge(order, 2, 6);
+  addEdge(order, 6, 3);
+  addEdge(order, 5, 0);
+  addEdge(order, 1, 4);
+
+  // Once an edge is removed, an edge that closed a cycle through it is accepted
+  printf("Remove 2 -> 6: %d\n", GraphDynTopoOrderRemoveEdge(order, 2, 6));
+  addEdge(order, 6, 3);
+
+  GraphDisplay(g01);
+
+  printf("Invariants: %d\n", GraphDynTopoOrderCheckInvariants(order));
+
+  // House-keeping
+  GraphDynTopoOrderDestroy(&order);
+  GraphDestroy(&g01);
+
+  return 0;
+}
@@ -0,0 +1,221 @@
+//
+// Algoritmos e Estruturas de Dados --- 2023/2024
+//
+// CONCURRENT QUEUES EXAMPLE
+//
+// Several threads pass integers through the lock-free queues, one at a time
+// and in batches, and every value sent is checked to be received exactly once
+// (and, through the SPSC queue, in order)
+//
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "IntegersConcurrentQueue.h"
+
+// Values sent by each producer
+#define NUM_VALUES 100000u
+
+// Threads using the MPMC queue
+#define NUM_PRODUCERS 4
+#define NUM_CONSUMERS 4
+
+// Small queues, so that they are often full (and empty)
+#define QUEUE_SIZE 1024
+
+#define BATCH_SIZE 16
+
+// SPSC: one producer and one consumer
+
+static void* spscProducer(void* arg) {
+  SPSCQueue* q = (SPSCQueue*)arg;
+  unsigned int batch[BATCH_SIZE];
+
+  unsigned int i = 0;
+  while (i < NUM_VALUES) {
+    if (i % 3 == 0) {
+      // Every third value starts a batch
+      unsigned int count = 0;
+      while (count < BATCH_SIZE && i + count < NUM_VALUES) {
+        batch[count] = i + count;
+        count++;
+      }
+      unsigned int sent = 0;
+      while (sent < count) {
+        sent += (unsigned int)SPSCQueueEnqueueBatch(q, &batch[sent], count - sent);
+      }
+      i += count;
+    } else {
+      SPSCQueueEnqueue(q, i);
+      i++;
+    }
+  }
+  return NULL;
+}
+
+static int spscExample(void) {
+  SPSCQueue* q = SPSCQueueCreate(QUEUE_SIZE);
+
+  pthread_t producer;
+  if (pthread_create(&producer, NULL, spscProducer, q) != 0) {
+    perror("pthread_create");
+    exit(1);
+  }
+
+  // The consumer is this thread: the values must arrive in the order sent
+  unsigned int batch[BATCH_SIZE];
+  unsigned int expected = 0;
+  int inOrder = 1;
+  while (expected < NUM_VALUES) {
+    size_t count = SPSCQueueDequeueBatch(q, batch, BATCH_SIZE);
+    if (count == 0) {
+      batch[0] = SPSCQueueDequeue(q);
+      count = 1;
+    }
+    for (size_t k = 0; k < count; k++) {
+      if (batch[k] != expected) inOrder = 0;
+      expected++;
+    }
+  }
+
+  pthread_join(producer, NULL);
+
+  int ok = inOrder && SPSCQueueIsEmpty(q);
+  printf("SPSC: %u values, 1 producer, 1 consumer: %s\n", NUM_VALUES, ok ? "OK" : "FAILED");
+
+  SPSCQueueDestroy(&q);
+  return ok;
+}
+
+// MPMC: several producers and consumers
+
+struct MPMCThread {
+  MPMCQueue* q;
+  unsigned int id;
+  unsigned int* received;  // Consumers: how many times each value arrived
+};
+
+// Producer id sends the values [id * NUM_VALUES, (id + 1) * NUM_VALUES)
+static void* mpmcProducer(void* arg) {
+  struct MPMCThread* t = (struct MPMCThread*)arg;
+  unsigned int first = t->id * NUM_VALUES;
+  unsigned int batch[BATCH_SIZE];
+
+  unsigned int i = 0;
+  while (i < NUM_VALUES) {
+    if (t->id % 2 == 0) {
+      unsigned int count = 0;
+      while (count < BATCH_SIZE && i + count < NUM_VALUES) {
+        batch[count] = first + i + count;
+        count++;
+      }
+      unsigned int sent = 0;
+      while (sent < count) {
+        sent += (unsigned int)MPMCQueueEnqueueBatch(t->q, &batch[sent], count - sent);
+      }
+      i += count;
+    } else {
+      MPMCQueueEnqueue(t->q, first + i);
+      i++;
+    }
+  }
+  return NULL;
+}
+
+// Consumers stop when they receive the value past the last one (one each)
+#define STOP (NUM_PRODUCERS * NUM_VALUES)
+
+static void* mpmcConsumer(void* arg) {
+  struct MPMCThread* t = (struct MPMCThread*)arg;
+  unsigned int batch[BATCH_SIZE];
+
+  for (;;) {
+    size_t count = MPMCQueueDequeueBatch(t->q, batch, (t->id % 2 == 0) ? BATCH_SIZE : 1);
+    if (count == 0) {
+      batch[0] = MPMCQueueDequeue(t->q);
+      count = 1;
+    }
+    for (size_t k = 0; k < count; k++) {
+      if (batch[k] == STOP) {
+        // Only STOPs come after a STOP: those of the other consumers go back
+        for (size_t j = k + 1; j < count; j++) {
+          MPMCQueueEnqueue(t->q, batch[j]);
+        }
+        return NULL;
+      }
+      t->received[batch[k]]++;
+    }
+  }
+}
+
+static int mpmcExample(void) {
+  MPMCQueue* q = MPMCQueueCreate(QUEUE_SIZE);
+
+  struct MPMCThread producers[NUM_PRODUCERS];
+  struct MPMCThread consumers[NUM_CONSUMERS];
+  pthread_t threads[NUM_PRODUCERS + NUM_CONSUMERS];
+
+  for (unsigned int c = 0; c < NUM_CONSUMERS; c++) {
+    consumers[c].q = q;
+    consumers[c].id = c;
+    consumers[c].received = (unsigned int*)calloc(STOP, sizeof(unsigned int));
+    if (consumers[c].received == NULL) abort();
+    if (pthread_create(&threads[c], NULL, mpmcConsumer, &consumers[c]) != 0) {
+      perror("pthread_create");
+      exit(1);
+    }
+  }
+  for (unsigned int p = 0; p < NUM_PRODUCERS; p++) {
+    producers[p].q = q;
+    producers[p].id = p;
+    if (pthread_create(&threads[NUM_CONSUMERS + p], NULL, mpmcProducer, &producers[p]) != 0) {
+      perror("pthread_create");
+      exit(1);
+    }
+  }
+
+  for (unsigned int p = 0; p < NUM_PRODUCERS; p++) {
+    pthread_join(threads[NUM_CONSUMERS + p], NULL);
+  }
+
+  // All values were sent: one STOP for each consumer
+  for (unsigned int c = 0; c < NUM_CONSUMERS; c++) {
+    MPMCQueueEnqueue(q, STOP);
+  }
+  for (unsigned int c = 0; c < NUM_CONSUMERS; c++) {
+    pthread_join(threads[c], NULL);
+  }
+
+  // Every value must have been received by exactly one consumer, once
+  unsigned int missing = 0;
+  unsigned int duplicated = 0;
+  for (unsigned int i = 0; i < STOP; i++) {
+    unsigned int times = 0;
+    for (unsigned int c = 0; c < NUM_CONSUMERS; c++) {
+      times += consumers[c].received[i];
+    }
+    if (times == 0) missing++;
+    if (times > 1) duplicated++;
+  }
+
+  int ok = (missing == 0 && duplicated == 0 && MPMCQueueIsEmpty(q));
+  printf("MPMC: %u values, %d producers, %d consumers: ", STOP, NUM_PRODUCERS, NUM_CONSUMERS);
+  if (ok) {
+    printf("OK\n");
+  } else {
+    printf("FAILED (%u missing, %u duplicated)\n", missing, duplicated);
+  }
+
+  for (unsigned int c = 0; c < NUM_CONSUMERS; c++) {
+    free(consumers[c].received);
+  }
+  MPMCQueueDestroy(&q);
+  return ok;
+}
+
+int main(void) {
+  int ok = spscExample();
+  ok = mpmcExample() && ok;
+  return ok ? 0 : 1;
+}
@@ -9,19 +9,21 @@
 /// // Name the counters you're going to use: 
 /// InstrName[0] = "memops";
 /// InstrName[1] = "adds";
-/// InstrCalibrate();  // Call once, to measure CTU
+/// InstrCalibrate();  // Call once, to have times also shown in CTU
 /// ...
 /// InstrReset();  // reset to zero
 /// for (...) {
-///   InstrCount[0] += 3;  // to count array acesses
-///   InstrCount[1] += 1;  // to count addition
+///   InstrAdd(0, 3);  // to count array acesses
+///   InstrInc(1);     // to count addition
 ///   a[k] = a[i] + a[j];
 /// }
 /// InstrPrint();  // to show time and counters
 
 #include "instrumentation.h"
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /// Cpu time in seconds
 double cpu_time(void) ; ///
@@ -42,6 +44,19 @@ double cpu_time(void) {
   return (double)current_time.tv_sec + 1.0e-9 * (double)current_time.tv_nsec;
 }
 
+// Wall-clock time, and cpu time of the calling thread, in seconds
+static double clock_time(clockid_t clock) {
+  struct timespec current_time;
+
+  if (clock_gettime(clock, &current_time) != 0)
+    return -1.0;
+  return (double)current_time.tv_sec + 1.0e-9 * (double)current_time.tv_nsec;
+}
+
+static double wall_time(void) { return clock_time(CLOCK_MONOTONIC); }
+
+static double thread_cpu_time(void) { return clock_time(CLOCK_THREAD_CPUTIME_ID); }
+
 #endif
 
 
@@ -66,64 +81,507 @@ double cpu_time(void) {
   return (double)current_time.QuadPart / (double)frequency.QuadPart;
 }
 
+// Here, cpu_time is the wall-clock time: it stands for both
+static double wall_time(void) { return cpu_time(); }
+
+static double thread_cpu_time(void) { return cpu_time(); }
+
+#endif
+
+#ifdef __linux__
+
+//
+// Linux hardware performance counters
+//
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define INSTR_PERF 1
+
+static int perf_open(unsigned int type, unsigned long long config) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;        // started by InstrReset
+  attr.inherit = 1;         // also count the threads created afterwards
+  attr.exclude_kernel = 1;  // allowed with perf_event_paranoid <= 2
+  attr.exclude_hv = 1;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
 #endif
 
-/// Array of operation counters:
-unsigned long InstrCount[NUMCOUNTERS];  ///extern
+/// Array of operation counters of the calling thread:
+_Thread_local unsigned long InstrCount[NUMCOUNTERS];  ///extern
+
+/// Counts flushed by all threads
+static atomic_ulong InstrTotal[NUMCOUNTERS];
 
 /// Array of names for the counters:
 char* InstrName[NUMCOUNTERS] = {NULL};  ///extern
     // All elements initialized to NULL
     // See: https://en.cppreference.com/w/c/language/array_initialization
 
+/// Names of the hardware counters:
+const char* InstrHWName[NUMHWCOUNTERS] = {
+  "cycles", "instructions", "cache_misses", "branch_misses", "dtlb_misses"
+};  ///extern
+
+/// File descriptors of the open hardware counters (-1 if not open)
+static int InstrHWFd[NUMHWCOUNTERS] = {-1, -1, -1, -1, -1};
+
 /// Cpu_time read on previous reset (~seconds)
 double InstrTime;  ///extern
 
+/// Wall-clock time read on previous reset (seconds)
+static double InstrWallTime;
+
+/// Output format of InstrPrint, and whether the CSV header was printed
+static InstrFormat InstrOutputFormat = INSTR_TABLE;
+static int InstrCSVHeaderDone = 0;
+
+/// Labels of the CSV and JSON records
+struct InstrLabel {
+  const char* name;
+  char value[128];
+  int isNumber;
+};
+
+static struct InstrLabel InstrLabels[NUMLABELS];
+static int InstrNumLabels = 0;
+
 /// Calibrated Time Unit (in seconds, initially 1s)
 double InstrCTU = 1.0;  ///extern
 
-/// Find the Calibrated Time Unit (CTU).
-/// Run and time a loop of basic memory and arithmetic operations to set
-/// a reasonably cpu-independent time unit.
-void InstrCalibrate(void) { ///
+/// Iterations of the loop that defines the CTU
+#define CALIBRATION_ITERATIONS 40000000
+
+/// Iterations actually timed in each run, and number of runs
+#define CALIBRATION_SAMPLE 400000
+#define CALIBRATION_RUNS 3
+
+/// Set by InstrCalibrate, cleared once the CTU is measured
+static int InstrCalibrationPending = 0;
+
+/// Time n iterations of the calibration loop.
+static double InstrCalibrationLoop(int n) {
   const int size = 4*1024;     // 2^12!
   const int mask = size - 1;
-  int array[size];  // alloc array in stack, not initialized on purpose
+  unsigned int array[size];  // alloc array in stack, not initialized on purpose
   double time = cpu_time();
   srand((unsigned int)(time*1e9));
-  for (int n = 0; n < 40000000; n++) {
-    int i = rand() & mask;
-    int j = rand() & mask;
-    int k = rand() & mask;
+  for (; n > 0; n--) {
+    // unsigned, so that the sums wrap around instead of overflowing
+    unsigned int i = (unsigned int)(rand() & mask);
+    unsigned int j = (unsigned int)(rand() & mask);
+    unsigned int k = (unsigned int)(rand() & mask);
     array[k] ^= array[i] + array[j] + i*j;
     //printf("%d %d %d\n", i, j, k);  // debug
   }
-  InstrCTU = cpu_time() - time;
+  return cpu_time() - time;
+}
+
+/// Find the Calibrated Time Unit (CTU), when it is first needed.
+void InstrCalibrate(void) { ///
+  InstrCalibrationPending = 1;
+}
+
+/// The CTU, measured now if InstrCalibrate asked for it.
+/// The loop takes a time proportional to its number of iterations, so a
+/// part of it, scaled, gives the CTU; the fastest run is the one least
+/// disturbed by other processes.
+double InstrGetCTU(void) { ///
+  if (InstrCalibrationPending) {
+    double best = InstrCalibrationLoop(CALIBRATION_SAMPLE);
+    for (int run = 1; run < CALIBRATION_RUNS; run++) {
+      double time = InstrCalibrationLoop(CALIBRATION_SAMPLE);
+      if (time < best)
+        best = time;
+    }
+    InstrCTU = best * ((double)CALIBRATION_ITERATIONS / CALIBRATION_SAMPLE);
+    InstrCalibrationPending = 0;
+  }
+  return InstrCTU;
+}
+
+/// Start measuring the hardware counters.
+int InstrHWEnable(void) { ///
+  int count = 0;
+#ifdef INSTR_PERF
+  const unsigned int types[NUMHWCOUNTERS] = {
+    PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+    PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE
+  };
+  const unsigned long long configs[NUMHWCOUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+  };
+  for (int k = 0; k < NUMHWCOUNTERS; k++) {
+    if (InstrHWFd[k] < 0)
+      InstrHWFd[k] = perf_open(types[k], configs[k]);
+    if (InstrHWFd[k] >= 0)
+      count++;
+  }
+#endif
+  return count;
+}
+
+/// Stop measuring the hardware counters.
+void InstrHWDisable(void) { ///
+#ifdef INSTR_PERF
+  for (int k = 0; k < NUMHWCOUNTERS; k++) {
+    if (InstrHWFd[k] >= 0)
+      close(InstrHWFd[k]);
+    InstrHWFd[k] = -1;
+  }
+#endif
 }
 
-/// Reset counters to zero and store cpu_time.
+/// Value of hardware counter k since the last reset (0 if it fails).
+static unsigned long long InstrHWRead(int k) {
+  unsigned long long value = 0;
+#ifdef INSTR_PERF
+  if (read(InstrHWFd[k], &value, sizeof(value)) != (ssize_t)sizeof(value))
+    value = 0;
+#else
+  (void)k;
+#endif
+  return value;
+}
+
+/// Reset counters (of the calling thread, and the totals) to zero and store
+/// cpu_time.
 void InstrReset(void) { ///
-  for (int i = 0; i < NUMCOUNTERS; i++)
+  for (int i = 0; i < NUMCOUNTERS; i++) {
     InstrCount[i] = 0ul;
+    atomic_store(&InstrTotal[i], 0ul);
+  }
+#ifdef INSTR_PERF
+  for (int k = 0; k < NUMHWCOUNTERS; k++) {
+    if (InstrHWFd[k] >= 0) {
+      ioctl(InstrHWFd[k], PERF_EVENT_IOC_RESET, 0);
+      ioctl(InstrHWFd[k], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+#endif
+  InstrWallTime = wall_time();
   InstrTime = cpu_time();
 }
 
+/// Add the counters of the calling thread to the totals, and zero them.
+void InstrFlush(void) { ///
+  for (int i = 0; i < NUMCOUNTERS; i++) {
+    if (InstrCount[i] != 0ul) {
+      atomic_fetch_add(&InstrTotal[i], InstrCount[i]);
+      InstrCount[i] = 0ul;
+    }
+  }
+}
+
+/// Total of counter i: the flushed counts plus those of the calling thread.
+unsigned long InstrGetCount(int i) { ///
+  return atomic_load(&InstrTotal[i]) + InstrCount[i];
+}
+
 // Print times and all named counter values
+static void InstrPrintRecord(double time, double walltime, double caltime, const unsigned long long* hw);
+
 void InstrPrint(void) { ///
+  // hardware counters, read right away:
+  unsigned long long hw[NUMHWCOUNTERS];
+  for (int k = 0; k < NUMHWCOUNTERS; k++)
+    hw[k] = (InstrHWFd[k] >= 0) ? InstrHWRead(k) : 0;
   // elapsed time since last reset:
   double time = cpu_time() - InstrTime;
-  // compute time in calibrated time units:
-  double caltime = time / InstrCTU;
+  double walltime = wall_time() - InstrWallTime;
+  // compute time in calibrated time units (only after all the readings,
+  // since the first call may run the calibration loop):
+  double caltime = time / InstrGetCTU();
+
+  if (InstrOutputFormat != INSTR_TABLE) {
+    InstrPrintRecord(time, walltime, caltime, hw);
+    return;
+  }
 
   printf("#%14.15s\t%15.15s", "time", "caltime");
   for (int i = 0; i < NUMCOUNTERS; i++)
     if (InstrName[i] != NULL)
       printf("\t%15.15s", InstrName[i]);
+  for (int k = 0; k < NUMHWCOUNTERS; k++)
+    if (InstrHWFd[k] >= 0)
+      printf("\t%15.15s", InstrHWName[k]);
   puts("");
   printf("%15.6f\t%15.6f", time, caltime);
   for (int i = 0; i < NUMCOUNTERS; i++)
     if (InstrName[i] != NULL)
-      printf("\t%15lu", InstrCount[i]);  
+      printf("\t%15lu", InstrGetCount(i));
+  for (int k = 0; k < NUMHWCOUNTERS; k++)
+    if (InstrHWFd[k] >= 0)
+      printf("\t%15llu", hw[k]);
   puts("");
 }
 
+
+void InstrSetFormat(InstrFormat format) { ///
+  InstrOutputFormat = format;
+  InstrCSVHeaderDone = 0;
+}
+
+void InstrSetLabel(const char* name, const char* value) { ///
+  int k = 0;
+  while (k < InstrNumLabels && strcmp(InstrLabels[k].name, name) != 0)
+    k++;
+  if (k == InstrNumLabels) {
+    if (InstrNumLabels == NUMLABELS) {
+      fprintf(stderr, "InstrSetLabel: too many labels (%s)\n", name);
+      return;
+    }
+    InstrNumLabels++;
+  }
+  InstrLabels[k].name = name;
+  snprintf(InstrLabels[k].value, sizeof(InstrLabels[k].value), "%s", value);
+  InstrLabels[k].isNumber = 0;
+}
+
+void InstrSetLabelNumber(const char* name, double value) { ///
+  char text[64];
+  snprintf(text, sizeof(text), "%.15g", value);
+  InstrSetLabel(name, text);
+  for (int k = 0; k < InstrNumLabels; k++)
+    if (strcmp(InstrLabels[k].name, name) == 0)
+      InstrLabels[k].isNumber = 1;
+}
+
+void InstrClearLabels(void) { ///
+  InstrNumLabels = 0;
+}
+
+/// Print a string as a CSV field (quoted, if needed).
+static void InstrPrintCSVField(const char* s) {
+  if (strpbrk(s, ",\"\n\r") == NULL) {
+    fputs(s, stdout);
+    return;
+  }
+  putchar('"');
+  for (; *s != '\0'; s++) {
+    if (*s == '"')
+      putchar('"');
+    putchar(*s);
+  }
+  putchar('"');
+}
+
+static void InstrPrintJSONString(FILE* f, const char* s);
+
+/// Print one CSV or JSON record: labels, times, named and hardware counters.
+static void InstrPrintRecord(double time, double walltime, double caltime, const unsigned long long* hw) {
+  const char* timeNames[3] = {"time", "walltime", "caltime"};
+  double times[3] = {time, walltime, caltime};
+
+  if (InstrOutputFormat == INSTR_CSV) {
+    if (!InstrCSVHeaderDone) {
+      for (int k = 0; k < InstrNumLabels; k++) {
+        InstrPrintCSVField(InstrLabels[k].name);
+        putchar(',');
+      }
+      printf("%s,%s,%s", timeNames[0], timeNames[1], timeNames[2]);
+      for (int i = 0; i < NUMCOUNTERS; i++)
+        if (InstrName[i] != NULL) {
+          putchar(',');
+          InstrPrintCSVField(InstrName[i]);
+        }
+      for (int k = 0; k < NUMHWCOUNTERS; k++)
+        if (InstrHWFd[k] >= 0)
+          printf(",%s", InstrHWName[k]);
+      puts("");
+      InstrCSVHeaderDone = 1;
+    }
+    for (int k = 0; k < InstrNumLabels; k++) {
+      InstrPrintCSVField(InstrLabels[k].value);
+      putchar(',');
+    }
+    printf("%.9f,%.9f,%.9f", times[0], times[1], times[2]);
+    for (int i = 0; i < NUMCOUNTERS; i++)
+      if (InstrName[i] != NULL)
+        printf(",%lu", InstrGetCount(i));
+    for (int k = 0; k < NUMHWCOUNTERS; k++)
+      if (InstrHWFd[k] >= 0)
+        printf(",%llu", hw[k]);
+    puts("");
+    return;
+  }
+
+  // JSON: labels, then times, then counters, as members of a single object
+  putchar('{');
+  for (int k = 0; k < InstrNumLabels; k++) {
+    InstrPrintJSONString(stdout, InstrLabels[k].name);
+    putchar(':');
+    if (InstrLabels[k].isNumber)
+      fputs(InstrLabels[k].value, stdout);
+    else
+      InstrPrintJSONString(stdout, InstrLabels[k].value);
+    putchar(',');
+  }
+  for (int t = 0; t < 3; t++)
+    printf("%s\"%s\":%.9f", (t == 0) ? "" : ",", timeNames[t], times[t]);
+  for (int i = 0; i < NUMCOUNTERS; i++)
+    if (InstrName[i] != NULL) {
+      putchar(',');
+      InstrPrintJSONString(stdout, InstrName[i]);
+      printf(":%lu", InstrGetCount(i));
+    }
+  for (int k = 0; k < NUMHWCOUNTERS; k++)
+    if (InstrHWFd[k] >= 0)
+      printf(",\"%s\":%llu", InstrHWName[k], hw[k]);
+  puts("}");
+}
+
+
+/// Regions
+
+/// Maximum nesting of the regions of a thread
+#define MAX_REGION_DEPTH 64
+
+/// A region being timed
+struct InstrOpenRegion {
+  const char* name;
+  double wallStart;
+  double cpuStart;
+};
+
+/// A finished region
+struct InstrRegion {
+  const char* name;
+  unsigned int thread;  // number of the thread, from 1
+  unsigned int depth;   // 0 for the outermost regions
+  double wallStart;     // seconds, since the first region began
+  double wallTime;
+  double cpuTime;
+};
+
+/// Regions being timed by the calling thread (innermost last)
+static _Thread_local struct InstrOpenRegion InstrOpen[MAX_REGION_DEPTH];
+static _Thread_local unsigned int InstrDepth = 0;
+static _Thread_local unsigned int InstrThread = 0;  // 0 until its first region
+
+static atomic_uint InstrNumThreads;
+
+/// Finished regions of all threads, guarded by a spin lock
+static struct InstrRegion* InstrRegions = NULL;
+static size_t InstrNumRegions = 0;
+static size_t InstrRegionsCapacity = 0;
+static atomic_flag InstrRegionsLock = ATOMIC_FLAG_INIT;
+
+/// Time origin of the trace (the start of the first region)
+static double InstrOrigin = -1.0;
+
+void InstrRegionBegin(const char* name) { ///
+  if (InstrThread == 0)
+    InstrThread = atomic_fetch_add(&InstrNumThreads, 1) + 1;
+  if (InstrDepth == MAX_REGION_DEPTH) {
+    fprintf(stderr, "InstrRegionBegin: regions nested too deep (%s)\n", name);
+    abort();
+  }
+  struct InstrOpenRegion* r = &InstrOpen[InstrDepth++];
+  r->name = name;
+  r->cpuStart = thread_cpu_time();
+  r->wallStart = wall_time();
+}
+
+void InstrRegionEnd(void) { ///
+  double wall = wall_time();
+  double cpu = thread_cpu_time();
+  if (InstrDepth == 0) {
+    fprintf(stderr, "InstrRegionEnd: no region to end\n");
+    abort();
+  }
+  struct InstrOpenRegion* r = &InstrOpen[--InstrDepth];
+
+  while (atomic_flag_test_and_set_explicit(&InstrRegionsLock, memory_order_acquire))
+    ;
+  if (InstrNumRegions == InstrRegionsCapacity) {
+    InstrRegionsCapacity = (InstrRegionsCapacity == 0) ? 64 : 2 * InstrRegionsCapacity;
+    InstrRegions = (struct InstrRegion*)realloc(InstrRegions, InstrRegionsCapacity * sizeof(struct InstrRegion));
+    if (InstrRegions == NULL) abort();
+  }
+  if (InstrOrigin < 0.0 || r->wallStart < InstrOrigin)
+    InstrOrigin = r->wallStart;
+  struct InstrRegion* e = &InstrRegions[InstrNumRegions++];
+  e->name = r->name;
+  e->thread = InstrThread;
+  e->depth = InstrDepth;
+  e->wallStart = r->wallStart;
+  e->wallTime = wall - r->wallStart;
+  e->cpuTime = cpu - r->cpuStart;
+  atomic_flag_clear_explicit(&InstrRegionsLock, memory_order_release);
+}
+
+/// Print a string as a JSON string.
+static void InstrPrintJSONString(FILE* f, const char* s) {
+  fputc('"', f);
+  for (; *s != '\0'; s++) {
+    if (*s == '"' || *s == '\\')
+      fprintf(f, "\\%c", *s);
+    else if ((unsigned char)*s < 0x20)
+      fprintf(f, "\\u%04x", (unsigned char)*s);
+    else
+      fputc(*s, f);
+  }
+  fputc('"', f);
+}
+
+int InstrRegionsWriteTrace(const char* fileName) { ///
+  FILE* f = fopen(fileName, "w");
+  if (f == NULL) {
+    perror(fileName);
+    return -1;
+  }
+
+  while (atomic_flag_test_and_set_explicit(&InstrRegionsLock, memory_order_acquire))
+    ;
+  // Complete ("X") events, with times in microseconds
+  fprintf(f, "{\"traceEvents\":[");
+  for (size_t k = 0; k < InstrNumRegions; k++) {
+    const struct InstrRegion* e = &InstrRegions[k];
+    fprintf(f, "%s\n{\"name\":", (k == 0) ? "" : ",");
+    InstrPrintJSONString(f, e->name);
+    fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+               "\"args\":{\"depth\":%u,\"cpu_us\":%.3f}}",
+            e->thread, 1e6 * (e->wallStart - InstrOrigin), 1e6 * e->wallTime,
+            e->depth, 1e6 * e->cpuTime);
+  }
+  fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  atomic_flag_clear_explicit(&InstrRegionsLock, memory_order_release);
+
+  return (fclose(f) == 0) ? 0 : -1;
+}
+
+void InstrRegionsPrint(void) { ///
+  while (atomic_flag_test_and_set_explicit(&InstrRegionsLock, memory_order_acquire))
+    ;
+  printf("#%7s\t%5s\t%-31s\t%15s\t%15s\n", "thread", "depth", "region", "wall", "cpu");
+  for (size_t k = 0; k < InstrNumRegions; k++) {
+    const struct InstrRegion* e = &InstrRegions[k];
+    printf("%8u\t%5u\t%-31.31s\t%15.6f\t%15.6f\n", e->thread, e->depth, e->name,
+           e->wallTime, e->cpuTime);
+  }
+  atomic_flag_clear_explicit(&InstrRegionsLock, memory_order_release);
+}
+
+void InstrRegionsClear(void) { ///
+  while (atomic_flag_test_and_set_explicit(&InstrRegionsLock, memory_order_acquire))
+    ;
+  free(InstrRegions);
+  InstrRegions = NULL;
+  InstrNumRegions = 0;
+  InstrRegionsCapacity = 0;
+  InstrOrigin = -1.0;
+  atomic_flag_clear_explicit(&InstrRegionsLock, memory_order_release);
+}
@@ -9,15 +9,37 @@
 /// // Name the counters you're going to use: 
 /// InstrName[0] = "memops";
 /// InstrName[1] = "adds";
-/// InstrCalibrate();  // Call once, to measure CTU
+/// InstrCalibrate();  // Call once, to have times also shown in CTU
 /// ...
 /// InstrReset();  // reset to zero
 /// for (...) {
-///   InstrCount[0] += 3;  // to count array acesses
-///   InstrCount[1] += 1;  // to count addition
+///   InstrAdd(0, 3);  // to count array acesses
+///   InstrInc(1);     // to count addition
 ///   a[k] = a[i] + a[j];
 /// }
 /// InstrPrint();  // to show time and counters
+///
+/// The counters are thread-local: each thread counts in its own array, with
+/// no races and no shared cache lines. A thread other than the one calling
+/// InstrPrint must call InstrFlush before it finishes, to add its counts to
+/// the totals.
+///
+/// InstrPrint writes a table for people to read by default; InstrSetFormat
+/// switches it to CSV or JSON records, which also carry the labels set with
+/// InstrSetLabel (e.g. the input file and the algorithm being measured).
+///
+/// On Linux, InstrHWEnable adds hardware counters (cycles, instructions,
+/// cache misses, ...), measured by the kernel from InstrReset to InstrPrint.
+///
+/// Named regions of code can also be timed (wall-clock and cpu time, per
+/// thread), and nested:
+///
+/// INSTR_REGION("load") {
+///   g = GraphFromFile(f);
+/// }
+///
+/// Building with -DNINSTR (as with -DNDEBUG for assert) compiles InstrInc and
+/// InstrAdd to nothing, and the counters stay at 0.
 
 #ifndef INSTRUMENTATION_H
 #define INSTRUMENTATION_H
@@ -28,8 +50,17 @@ double cpu_time(void) ; ///
 /// Ten counters should be more than enough
 #define NUMCOUNTERS 10
 
-/// Array of operation counters:
-extern unsigned long InstrCount[NUMCOUNTERS];  ///extern
+/// Array of operation counters of the calling thread:
+extern _Thread_local unsigned long InstrCount[NUMCOUNTERS];  ///extern
+
+/// Add n to counter i (of the calling thread)
+#ifdef NINSTR
+#define InstrAdd(i, n) ((void)(i), (void)(n))
+#else
+#define InstrAdd(i, n) ((void)(InstrCount[(i)] += (unsigned long)(n)))
+#endif
+
+#define InstrInc(i) InstrAdd((i), 1)
 
 /// Array of names for the counters:
 extern char* InstrName[NUMCOUNTERS];  ///extern
@@ -38,17 +69,94 @@ extern char* InstrName[NUMCOUNTERS];  ///extern
 extern double InstrTime;  ///extern
 
 /// Calibrated Time Unit (in seconds, initially 1s)
+/// Use InstrGetCTU, which measures it first if it is still pending.
 extern double InstrCTU;  ///extern
 
-/// Find the Calibrated Time Unit (CTU).
-/// Run and time a loop of basic memory and arithmetic operations to set
-/// a reasonably cpu-independent time unit.
+/// Find the Calibrated Time Unit (CTU): the time of a loop of 40 million
+/// basic memory and arithmetic operations, a reasonably cpu-independent
+/// time unit.
+/// The measurement is lazy (it is only done when the CTU is first needed)
+/// and short: the best of a few runs of a small part of the loop, scaled.
 void InstrCalibrate(void) ;
 
-/// Reset counters to zero and store cpu_time.
+/// The CTU, measured now if InstrCalibrate asked for it.
+double InstrGetCTU(void) ;
+
+/// Reset counters (of the calling thread, and the totals) to zero and store
+/// cpu_time.
 void InstrReset(void) ;
 
+/// Add the counters of the calling thread to the totals, and zero them.
+void InstrFlush(void) ;
+
+/// Total of counter i: the flushed counts plus those of the calling thread.
+unsigned long InstrGetCount(int i) ;
+
 void InstrPrint(void) ;
 
+/// Output formats of InstrPrint:
+///   INSTR_TABLE - a header line (starting with #) and a line of values
+///   INSTR_CSV   - a line of comma-separated values (after a header line,
+///                 the first time), with the labels first
+///   INSTR_JSON  - a JSON object on a single line (JSON Lines)
+/// The CSV and JSON records also carry the wall-clock time, as "walltime".
+typedef enum { INSTR_TABLE, INSTR_CSV, INSTR_JSON } InstrFormat;
+
+void InstrSetFormat(InstrFormat format) ;
+
+/// Maximum number of labels
+#define NUMLABELS 8
+
+/// Set (or change) the label name, shown in the CSV and JSON records.
+/// name must stay valid (it is only copied by reference); value is copied.
+void InstrSetLabel(const char* name, const char* value) ;
+
+/// Same, for a numeric label.
+void InstrSetLabelNumber(const char* name, double value) ;
+
+/// Remove all labels.
+void InstrClearLabels(void) ;
+
+/// Number of hardware counters
+#define NUMHWCOUNTERS 5
+
+/// Names of the hardware counters:
+extern const char* InstrHWName[NUMHWCOUNTERS];  ///extern
+
+/// Start measuring the hardware counters (of the whole process, including
+/// the threads it creates), using Linux perf_event_open, and print them
+/// after the named counters.
+/// Returns how many counters are available: 0 on other systems, or when the
+/// kernel does not allow it (see /proc/sys/kernel/perf_event_paranoid).
+int InstrHWEnable(void) ;
+
+void InstrHWDisable(void) ;
+
+/// Regions
+
+/// Start timing a region, inside the current region of the calling thread
+/// (if any). name must stay valid: it is only copied by reference.
+void InstrRegionBegin(const char* name) ;
+
+/// Stop timing the innermost region of the calling thread.
+void InstrRegionEnd(void) ;
+
+/// Time the block (or statement) that follows as a region. The block must
+/// not be left with break, goto or return, which would skip the end.
+#define INSTR_REGION(name) \
+  for (int instr_once_ = (InstrRegionBegin(name), 1); instr_once_; \
+       instr_once_ = (InstrRegionEnd(), 0))
+
+/// Write the finished regions to a file, in the Chrome trace event format
+/// (for chrome://tracing or https://ui.perfetto.dev).
+/// Returns 0 on success, and -1 on failure.
+int InstrRegionsWriteTrace(const char* fileName) ;
+
+/// Print the finished regions, in the order in which they finished.
+void InstrRegionsPrint(void) ;
+
+/// Forget the finished regions.
+void InstrRegionsClear(void) ;
+
 #endif
 